@@ -0,0 +1,61 @@
+#include "../simpleplot/render/aaline.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace SimplePlot::Render;
+
+
+namespace {
+	// A random walk with steps of about the given length, like a dense line plot.
+	std::vector<Segment> makeSegments(int count, float length, int width, int height) {
+		std::mt19937 rng(1234);
+		std::uniform_real_distribution<float> step(-length, length);
+		std::vector<Segment> segments(count);
+		float x = width / 2.0f;
+		float y = height / 2.0f;
+		for (Segment& s : segments) {
+			float nx = x + step(rng);
+			float ny = y + step(rng);
+			if (nx < 0 || nx >= width) { nx = x - (nx - x); }
+			if (ny < 0 || ny >= height) { ny = y - (ny - y); }
+			s = { x, y, nx, ny };
+			x = nx;
+			y = ny;
+		}
+		return segments;
+	}
+}
+
+int main() {
+	const int width = 1920;
+	const int height = 1080;
+	const int batch = 4096;
+	Framebuffer fb(width, height);
+	CoverageMask mask;
+	mask.reset(0, 0, width, height);
+
+	printf("width,segment_length,segments,seconds,segments_per_second\n");
+	for (float length : { 2.0f, 8.0f, 64.0f }) {
+		std::vector<Segment> segments = makeSegments(1 << 18, length, width, height);
+		for (int penWidth = 1; penWidth <= 3; penWidth++) {
+			fb.clear(0xffffffff);
+			long long drawn = 0;
+			auto start = std::chrono::steady_clock::now();
+			double seconds = 0;
+			while (seconds < 0.5) {
+				for (size_t i = 0; i < segments.size(); i += batch) {
+					coverSegments(mask, segments.data() + i, batch, (float)penWidth);
+					blendCoverage(fb, mask, 0xff0000ff);
+					mask.clear();
+				}
+				drawn += segments.size();
+				seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			}
+			printf("%d,%g,%lld,%.3f,%.0f\n", penWidth, length, drawn, seconds, drawn / seconds);
+		}
+	}
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "../simpleplot/stats.h"
+#include "../simpleplot/transform.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace SimplePlot;
+
+
+namespace {
+	volatile double sink;// Keeps results alive so the kernels aren't optimised away
+
+	template<typename T> char const* typeName();
+	template<> char const* typeName<float>() { return "float"; }
+	template<> char const* typeName<double>() { return "double"; }
+	template<> char const* typeName<int>() { return "int"; }
+	template<> char const* typeName<long long>() { return "int64"; }
+
+	// Runs f until minSeconds have passed (at least once) and returns the fastest run in seconds.
+	template<typename F>
+	double best(F f, double minSeconds = 0.2) {
+		double fastest = 1e300;
+		double total = 0;
+		do {
+			auto start = std::chrono::steady_clock::now();
+			f();
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			fastest = (std::min)(fastest, seconds);
+			total += seconds;
+		} while (total < minSeconds);
+		return fastest;
+	}
+
+	void report(char const* kernel, char const* type, long long elements, double seconds, double bytes) {
+		printf("%s,%s,%lld,%.4f,%.3f\n", kernel, type, elements, seconds * 1e9 / elements, bytes / seconds / 1e9);
+	}
+
+	template<typename T>
+	std::vector<T> makeData(long long count, unsigned int seed) {
+		// Uniform over [0, 1000), like a typical plot's samples.
+		std::mt19937 rng(seed);
+		std::uniform_real_distribution<double> value(0, 1000);
+		std::vector<T> data(count);
+		for (T& v : data) { v = (T)value(rng); }
+		return data;
+	}
+
+	template<typename T>
+	void benchStats(std::vector<long long> const& sizes) {
+		std::vector<T> data = makeData<T>(sizes.back(), 1);
+		for (long long n : sizes) {
+			double bytes = (double)n * sizeof(T);
+			report("minValue", typeName<T>(), n, best([&] { sink = (double)Stats::minValue<T>(data.data(), (int)n); }), bytes);
+			report("maxValue", typeName<T>(), n, best([&] { sink = (double)Stats::maxValue<T>(data.data(), (int)n); }), bytes);
+		}
+	}
+
+	template<typename T>
+	void benchBinFind(std::vector<long long> const& sizes) {
+		// Lookups of random values in a sorted table of n entries; elements is the table size, and the time is
+		// per lookup.
+		const int lookups = 1 << 20;
+		std::vector<T> table = makeData<T>(sizes.back(), 2);
+		std::vector<T> queries = makeData<T>(lookups, 3);
+		for (long long n : sizes) {
+			std::vector<T> sorted(table.begin(), table.begin() + n);
+			std::sort(sorted.begin(), sorted.end());
+			for (T& q : queries) { q = (std::max)(q, sorted.front()); }// Below the first bin is not allowed
+			double seconds = best([&] {
+				long long sum = 0;
+				for (T q : queries) { sum += Stats::binFindLeft<T>(sorted.data(), (int)n, q); }
+				sink = (double)sum;
+			});
+			printf("%s,%s,%lld,%.4f,%.3f\n", "binFindLeft", typeName<T>(), n, seconds * 1e9 / lookups, lookups * sizeof(T) / seconds / 1e9);
+		}
+	}
+
+	template<typename T>
+	void benchHist(std::vector<long long> const& sizes) {
+		std::vector<T> data = makeData<T>(sizes.back(), 4);
+		const int numBins = 64;
+		std::vector<int> counts(numBins);
+		std::vector<T> leftBins(numBins);
+		for (int i = 0; i < numBins; i++) {
+			leftBins[i] = (T)(1000.0 * i / numBins);
+		}
+		for (long long n : sizes) {
+			double bytes = (double)n * sizeof(T);
+			report("histUniform", typeName<T>(), n, best([&] {
+				std::fill(counts.begin(), counts.end(), 0);
+				Stats::countUniformBins<T>(data.data(), (int)n, (T)0, (T)1000, numBins, counts.data());
+				sink = counts[0];
+			}), bytes);
+			report("histCustom", typeName<T>(), n, best([&] {
+				std::fill(counts.begin(), counts.end(), 0);
+				Stats::countCustomBins<T>(data.data(), (int)n, leftBins.data(), numBins, counts.data());
+				sink = counts[0];
+			}), bytes);
+		}
+	}
+
+	template<typename T>
+	void benchTransform(std::vector<long long> const& sizes) {
+		// The per-point work of Line and Series, through the same functions they call. The log path is
+		// Transform::log10 ahead of the same map.
+		std::vector<T> xData = makeData<T>(sizes.back(), 5);
+		std::vector<T> yData = makeData<T>(sizes.back(), 6);
+		std::vector<float> xs(sizes.back());
+		std::vector<float> ys(sizes.back());
+		Transform::AffineMap mapX(0, 1000, 80, 1840);
+		Transform::AffineMap mapY(0, 1000, 1000, 80);
+		const long long origin = 0;
+		for (long long n : sizes) {
+			report("transformLinear", typeName<T>(), n, best([&] {
+				for (long long i = 0; i < n; i++) {
+					Transform::mapPoint(mapX, mapY, Transform::relative(xData[i], origin), Transform::relative(yData[i], origin), xs[i], ys[i]);
+				}
+				sink = xs[n - 1];
+			}), (double)n * (2 * sizeof(T) + 2 * sizeof(float)));
+			report("transformLog", typeName<T>(), n, best([&] {
+				Transform::log10<T>(xData.data(), xs.data(), (int)n);
+				Transform::log10<T>(yData.data(), ys.data(), (int)n);
+				for (long long i = 0; i < n; i++) {
+					Transform::mapPoint(mapX, mapY, xs[i], ys[i], xs[i], ys[i]);
+				}
+				sink = xs[n - 1];
+			}), (double)n * (2 * sizeof(T) + 4 * sizeof(float)));
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	// kernels_bench [max elements]. Sizes go up by 10x from 1e3; the default stops at 1e7 so a run takes about
+	// a minute, and 1e9 needs around 24 GB.
+	long long maxSize = argc > 1 ? (long long)std::atof(argv[1]) : 10000000;
+	std::vector<long long> sizes;
+	for (long long n = 1000; n <= maxSize; n *= 10) {
+		sizes.push_back(n);
+	}
+	if (sizes.empty()) {
+		fprintf(stderr, "max elements must be at least 1000\n");
+		return 1;
+	}
+
+	printf("kernel,type,elements,ns_per_element,gb_per_s\n");
+	benchStats<float>(sizes);
+	benchStats<double>(sizes);
+	benchStats<int>(sizes);
+	benchStats<long long>(sizes);
+	benchBinFind<float>(sizes);
+	benchBinFind<double>(sizes);
+	benchBinFind<int>(sizes);
+	benchHist<float>(sizes);
+	benchHist<double>(sizes);
+	benchHist<int>(sizes);
+	benchTransform<float>(sizes);
+	benchTransform<double>(sizes);
+	benchTransform<int>(sizes);
+	benchTransform<long long>(sizes);
+	return 0;
+}
\ No newline at end of file
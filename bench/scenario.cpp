@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "../simpleplot.h"
+#include "../simpleplot/render/pool.h"
+
+using namespace SimplePlot;
+
+
+// Every allocation in the process is counted, so allocations per frame include the library's own.
+namespace {
+	std::atomic<long long> allocations = 0;
+
+	void* countedAllocate(size_t size) {
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		void* p = std::malloc(size ? size : 1);
+		if (!p) { throw std::bad_alloc(); }
+		return p;
+	}
+}
+
+void* operator new(size_t size) { return countedAllocate(size); }
+void* operator new[](size_t size) { return countedAllocate(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+
+namespace {
+	struct Scenario {
+		int canvases;
+		int plots;// Per canvas, cycling through Line, Series and Hist
+		int points;// Per plot, once all data has arrived
+		bool streaming;// Starts at half the points and appends the rest evenly over the frames
+		int frames;
+		int width = 640;
+		int height = 360;
+	};
+
+	double peakRSS() {
+		// In megabytes
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters = { 0 };
+		GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+		return counters.PeakWorkingSetSize / 1048576.0;
+#else
+		rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_maxrss / 1024.0;
+#endif
+	}
+
+	double percentile(std::vector<double>& values, double p) {
+		// Nearest rank
+		std::sort(values.begin(), values.end());
+		size_t rank = (size_t)std::ceil(p * values.size());
+		return values[(std::min)((std::max)(rank, (size_t)1), values.size()) - 1];
+	}
+
+	// The data behind one plot. The arrays are sized for every point up front, so appends never move them.
+	struct PlotData {
+		std::vector<float> x;
+		std::vector<float> y;
+		PLOT_ID id = SP_NULL_PLOT;
+	};
+
+	void run(Scenario const& s) {
+		std::mt19937 rng(1234);
+		std::normal_distribution<float> normal;
+		int initial = s.streaming ? (std::max)(s.points / 2, 1) : s.points;
+		int perFrame = s.streaming ? (std::max)((s.points - initial) / (std::max)(s.frames, 1), 1) : 0;
+		int capacity = initial + perFrame * s.frames;
+
+		std::vector<PlotData> data(s.canvases * s.plots);
+		std::vector<CANVAS_ID> canvases;
+		for (int c = 0; c < s.canvases; c++) {
+			std::vector<PLOT_ID> ids;
+			for (int p = 0; p < s.plots; p++) {
+				PlotData& d = data[c * s.plots + p];
+				d.x.resize(capacity);
+				d.y.resize(capacity);
+				float walk = 0;
+				for (int i = 0; i < capacity; i++) {
+					walk += normal(rng);
+					d.x[i] = (float)i;
+					d.y[i] = p % 3 == 2 ? normal(rng) : walk;
+				}
+				switch (p % 3) {
+				case 0:
+					d.id = makeLine(d.x.data(), d.y.data(), initial, SP_BLUE, L"line");
+					break;
+				case 1:
+					d.id = makeSeries(1.0f, d.y.data(), initial, SP_PURPLE, L"series");
+					break;
+				default:
+					d.id = makeHist(d.y.data(), initial, 50, -4.0f, 4.0f, SP_GREEN, L"hist");
+					break;
+				}
+				ids.push_back(d.id);
+			}
+			canvases.push_back(makeOffscreenCanvas(ids, L"scenario"));
+		}
+		std::vector<Render::Framebuffer> framebuffers;
+		for (int c = 0; c < s.canvases; c++) {
+			framebuffers.emplace_back(s.width, s.height);
+		}
+
+		// One warm-up frame builds the caches that a long-running wall would already have.
+		for (int c = 0; c < s.canvases; c++) {
+			renderCanvas(canvases[c], framebuffers[c]);
+		}
+
+		std::vector<double> latencies(s.canvases * s.frames);
+		int size = initial;
+		long long allocationsBefore = allocations.load();
+		auto start = std::chrono::steady_clock::now();
+		for (int f = 0; f < s.frames; f++) {
+			if (s.streaming) {
+				size += perFrame;
+				for (PlotData& d : data) {
+					appendPlotData(d.id, size);
+				}
+			}
+			// A wall renders its canvases side by side; a single canvas uses the threads for its own tiles.
+			auto renderOne = [&](int c) {
+				auto frameStart = std::chrono::steady_clock::now();
+				renderCanvas(canvases[c], framebuffers[c], s.canvases == 1);
+				latencies[f * s.canvases + c] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count();
+			};
+			if (s.canvases == 1) {
+				renderOne(0);
+			}
+			else {
+				Render::getPool().parallelFor(s.canvases, renderOne);
+			}
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		long long allocated = allocations.load() - allocationsBefore;
+
+		int canvasFrames = s.canvases * s.frames;
+		printf("%d,%d,%d,%s,%d,%.1f,%.2f,%.3f,%.3f,%.3f,%.1f,%.1f\n", s.canvases, s.plots, s.points,
+			s.streaming ? "streaming" : "static", s.frames, canvasFrames / seconds, s.frames / seconds,
+			percentile(latencies, 0.50), percentile(latencies, 0.95), percentile(latencies, 0.99),
+			peakRSS(), (double)allocated / canvasFrames);
+		fflush(stdout);
+
+		for (CANVAS_ID id : canvases) {
+			deleteCanvas(id);
+		}
+		for (PlotData& d : data) {
+			deletePlot(d.id);
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	// scenario_bench [canvases plots points static|streaming [frames]] runs one scenario; with no arguments
+	// it runs the standard set, from one heavy canvas to a 120 canvas wall. Peak RSS only ever grows, so for
+	// a scenario's own peak run it alone.
+	std::vector<Scenario> scenarios;
+	if (argc >= 5) {
+		Scenario s = { std::atoi(argv[1]), std::atoi(argv[2]), (int)std::atof(argv[3]),
+			std::strcmp(argv[4], "streaming") == 0, argc >= 6 ? std::atoi(argv[5]) : 60 };
+		if (s.canvases < 1 || s.plots < 1 || s.points < 1 || s.frames < 1) {
+			fprintf(stderr, "canvases, plots, points and frames must be positive\n");
+			return 1;
+		}
+		scenarios.push_back(s);
+	}
+	else {
+		scenarios = {
+			{ 1, 3, 1000000, false, 30 },
+			{ 1, 3, 1000000, true, 30 },
+			{ 16, 3, 100000, false, 30 },
+			{ 16, 3, 100000, true, 30 },
+			{ 120, 3, 10000, false, 30 },
+			{ 120, 3, 10000, true, 30 },
+		};
+	}
+
+	printf("canvases,plots,points,data,frames,canvas_frames_per_s,wall_frames_per_s,p50_ms,p95_ms,p99_ms,peak_rss_mb,allocations_per_frame\n");
+	for (Scenario const& s : scenarios) {
+		run(s);
+	}
+	return 0;
+}
\ No newline at end of file
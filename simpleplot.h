@@ -2,4 +2,12 @@
 #include "simpleplot/plots/hist.h"
 #include "simpleplot/plots/line.h"
 #include "simpleplot/plots/series.h"
-#include "simpleplot/canvas.h"
\ No newline at end of file
+#include "simpleplot/plots/scatter.h"
+#include "simpleplot/canvas.h"
+#include "simpleplot/link.h"
+#include "simpleplot/export/png.h"
+#include "simpleplot/export/svg.h"
+#include "simpleplot/export/batch.h"
+#include "simpleplot/locks.h"
+#include "simpleplot/memory.h"
+#include "simpleplot/trace.h"
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include "axis.h"
 #include "standard.h"
 #include "stats.h"
+#include "resources.h"
+#include "text.h"
+#include "ticks.h"
 
 #include <stdexcept>
 #pragma warning(disable:4267)
@@ -13,23 +16,25 @@ namespace SimplePlot {
 		makePen();
 	}
 
-	Axis::Axis(std::string label, float maxT, float minT, bool logarithmic, SimplePlot::Style::Color backColor, SimplePlot::Style::Color color)
-		: label(label.begin(), label.end()), logarithmic(logarithmic), backColor(backColor), maxT(maxT), minT(minT), fixEnds(true) {
+	Axis::Axis(std::string label, double maxT, double minT, bool logarithmic, SimplePlot::Style::Color backColor, SimplePlot::Style::Color color)
+		: label(label.begin(), label.end()), logarithmic(logarithmic), backColor(backColor), maxT(maxT), minT(minT), fixEnds(true), color(color) {
 		makePen();
 	}
 
 	Axis::~Axis() {
-		DeleteObject(thickPen);
-		DeleteObject(thinPen);
-		DeleteObject(backPen);
-		DeleteObject(tickFont);
+		Resources::release(thickPen);
+		Resources::release(thinPen);
+		Resources::release(backPen);
+		Resources::release(tickFont);
+		Resources::release(labelFont);
+		Resources::release(flatLabelFont);
 	}
 
-	bool Axis::setEnds(float minT_, float maxT_) {
+	bool Axis::setEnds(double minT_, double maxT_) {
 		if (!fixEnds) {
 			minT = minT_;
 			maxT = maxT_;
-			setMajorMinor();
+			updateTicks();
 		}
 		return fixEnds;
 	}
@@ -40,15 +45,15 @@ namespace SimplePlot {
 	}
 
 	void Axis::makePen() {
-		thickPen = CreatePen(PS_SOLID, 2, Style::getColor(color));
-		thinPen = CreatePen(PS_SOLID, 1, Style::getColor(color));
+		thickPen = Resources::acquirePen(PS_SOLID, 2, Style::getColor(color));
+		thinPen = Resources::acquirePen(PS_SOLID, 1, Style::getColor(color));
 		COLORREF backCR = Style::getColor(backColor);
 		COLORREF foreCR = Style::getColor(color);
 		COLORREF penCR = RGB((GetRValue(backCR) + GetRValue(foreCR)) / 2, (GetGValue(backCR) + GetGValue(foreCR)) / 2, (GetBValue(backCR) + GetBValue(foreCR)) / 2);
-		backPen = CreatePen(PS_SOLID, 1, penCR);
+		backPen = Resources::acquirePen(PS_SOLID, 1, penCR);
 
-		tickFont = CreateFont(24, 0, 0, 0, 400, FALSE, FALSE, FALSE, ANSI_CHARSET, OUT_DEFAULT_PRECIS,
-			CLIP_DEFAULT_PRECIS, ANTIALIASED_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Calibri");
+		tickFont = Resources::acquireFont(L"Calibri", 24, 400);
+		flatLabelFont = Resources::acquireFont(L"Calibri", 28, 600);
 	}
 
 	void Axis::drawGrid(HDC hdc, POINT origin, POINT axisEnd, POINT gridEnd) {
@@ -61,21 +66,15 @@ namespace SimplePlot {
 
 		SelectObject(hdc, tickFont);
 
-		if (!logarithmic) {
-			for (int i = minT / minor; i * minor <= maxT; i++) {
-				float frac = float(i * minor - minT) / (maxT - minT);
-				POINT pos = { LONG(origin.x + frac * (axisEnd.x - origin.x)), LONG(origin.y + frac * (axisEnd.y - origin.y)) };
-				if (i != 0) {
-					MoveToEx(hdc, pos.x - tick.x, pos.y - tick.y, NULL);
-					SelectObject(hdc, backPen);
-					LineTo(hdc, pos.x + gridAxis.x, pos.y + gridAxis.y);
-					SelectObject(hdc, thinPen);
-				}
+		for (double value : tickCache.current().major) {
+			POINT pos = getTickPosition(value, origin, axisEnd);
+			if (pos.x != origin.x || pos.y != origin.y) {
+				MoveToEx(hdc, pos.x - tick.x, pos.y - tick.y, NULL);
+				SelectObject(hdc, backPen);
+				LineTo(hdc, pos.x + gridAxis.x, pos.y + gridAxis.y);
+				SelectObject(hdc, thinPen);
 			}
 		}
-		else {
-			throw std::logic_error("Not implemented");
-		}
 
 		SelectObject(hdc, oldPen);
 	}
@@ -93,27 +92,26 @@ namespace SimplePlot {
 
 		SelectObject(hdc, tickFont);
 
-		if (!logarithmic) {
-			for (int i = minT / minor; i * minor <= maxT; i++) {
-				float frac = float(i * minor - minT) / (maxT - minT);
-				POINT pos = { LONG(origin.x + frac * (axisEnd.x - origin.x)), LONG(origin.y + frac * (axisEnd.y - origin.y)) };
-				if (i != 0) {
-					// Go over ticks again; they're important.
-					MoveToEx(hdc, pos.x - tick.x, pos.y - tick.y, NULL);
-					LineTo(hdc, pos.x + tick.x, pos.y + tick.y);
-				}
-
-				// Numbers
-				RECT widthRect = { 0, 0, 0, 0 };
-				std::wstring number = SimplePlot::Stats::template round<float>(i * minor, (int)log10(minor));
-				DrawText(hdc, number.c_str(), number.size(), &widthRect, DT_CALCRECT);
-				RECT textRect = { pos.x - LONG(widthRect.right / 2), pos.y - LONG(widthRect.bottom / 2),
-					pos.x + LONG(widthRect.right / 2), pos.y + LONG(widthRect.bottom / 2) };
-				DrawText(hdc, number.c_str(), number.size(), &textRect, DT_LEFT);
-			}
+		Ticks::TickSet const& ticks = tickCache.current();
+		for (double value : ticks.minor) {
+			POINT pos = getTickPosition(value, origin, axisEnd);
+			MoveToEx(hdc, pos.x - tick.x / 2, pos.y - tick.y / 2, NULL);
+			LineTo(hdc, pos.x + tick.x / 2, pos.y + tick.y / 2);
 		}
-		else {
-			throw std::logic_error("Not implemented");
+		for (size_t i = 0; i < ticks.major.size(); i++) {
+			POINT pos = getTickPosition(ticks.major[i], origin, axisEnd);
+			if (pos.x != origin.x || pos.y != origin.y) {
+				// Go over ticks again; they're important.
+				MoveToEx(hdc, pos.x - tick.x, pos.y - tick.y, NULL);
+				LineTo(hdc, pos.x + tick.x, pos.y + tick.y);
+			}
+
+			// Numbers
+			std::wstring const& number = ticks.labels[i];
+			SIZE extent = Text::measure(number, tickFont);
+			RECT textRect = { pos.x - LONG(extent.cx / 2), pos.y - LONG(extent.cy / 2),
+				pos.x + LONG(extent.cx / 2), pos.y + LONG(extent.cy / 2) };
+			DrawText(hdc, number.c_str(), number.size(), &textRect, DT_LEFT);
 		}
 
 		// Box
@@ -126,9 +124,22 @@ namespace SimplePlot {
 		float angle = atan2(axisEnd.y - origin.y, axisEnd.x - origin.x);
 		int escapement = -angle * 180 / 3.14159265f * 10;
 
-		labelFont = CreateFont(28, 0, escapement, escapement, 600, FALSE, FALSE, FALSE, ANSI_CHARSET, OUT_DEFAULT_PRECIS,
-			CLIP_DEFAULT_PRECIS, ANTIALIASED_QUALITY, DEFAULT_PITCH | FF_DONTCARE, L"Calibri");
+		// The font depends on the axis direction, which almost never changes, so only swap it when it does.
+		if (labelFont == NULL || escapement != labelEscapement) {
+			HFONT newFont = Resources::acquireFont(L"Calibri", 28, 600, escapement);
+			Resources::release(labelFont);
+			labelFont = newFont;
+			labelEscapement = escapement;
+		}
 		HFONT oldFont = (HFONT)SelectObject(hdc, labelFont);
+		RECT labelRect = getLabelRect(origin, axisEnd, gridEnd);
+		DrawText(hdc, label.c_str(), label.size(), &labelRect, DT_CENTER | DT_NOCLIP | DT_VCENTER | DT_SINGLELINE);
+
+		SelectObject(hdc, oldFont);
+		SelectObject(hdc, oldPen);
+	}
+
+	RECT Axis::getLabelRect(POINT origin, POINT axisEnd, POINT gridEnd) const {
 		RECT labelRect;
 		POINT dropVector = { gridEnd.x - origin.x, gridEnd.y - origin.y };
 		float dropScale = -50 / sqrt(dropVector.x * dropVector.x + dropVector.y * dropVector.y);
@@ -139,18 +150,129 @@ namespace SimplePlot {
 		labelRect.bottom = max(max(max(origin.y, axisEnd.y), dropStart.y), dropEnd.y);
 		labelRect.left = min(min(min(origin.x, axisEnd.x), dropStart.x), dropEnd.x);
 		labelRect.right = max(max(max(origin.x, axisEnd.x), dropStart.x), dropEnd.x);
+		return labelRect;
+	}
 
-		SelectObject(hdc, labelFont);
-		DrawText(hdc, label.c_str(), label.size(), &labelRect, DT_CENTER | DT_NOCLIP | DT_VCENTER | DT_SINGLELINE);
+	void Axis::recordGrid(Render::DrawList& list, POINT origin, POINT axisEnd, POINT gridEnd) const {
+		if (!grid) { return; }
+		COLORREF backCR = Style::getColor(backColor);
+		COLORREF foreCR = Style::getColor(color);
+		COLORREF penCR = RGB((GetRValue(backCR) + GetRValue(foreCR)) / 2, (GetGValue(backCR) + GetGValue(foreCR)) / 2, (GetBValue(backCR) + GetBValue(foreCR)) / 2);
 
-		SelectObject(hdc, oldFont);
-		SelectObject(hdc, oldPen);
+		POINT gridAxis = { gridEnd.x - origin.x, gridEnd.y - origin.y };
+		float gridLength = sqrt(gridAxis.x * gridAxis.x + gridAxis.y * gridAxis.y);
+		POINT tick = { LONG(gridAxis.x / gridLength * SP_TICK_LENGTH), LONG(gridAxis.y / gridLength * SP_TICK_LENGTH) };
+
+		list.beginPath(Render::pixelFromColorRef(penCR), 1);
+		for (double value : tickCache.current().major) {
+			POINT pos = getTickPosition(value, origin, axisEnd);
+			if (pos.x != origin.x || pos.y != origin.y) {
+				list.moveTo(float(pos.x - tick.x), float(pos.y - tick.y));
+				list.lineTo(float(pos.x + gridAxis.x), float(pos.y + gridAxis.y));
+			}
+		}
+		list.endPath();
 	}
 
-	void Axis::setMajorMinor() {
-		/// TO DO: Implement
-		major = 5;
-		minor = 1;
+	void Axis::recordAxis(Render::DrawList& list, POINT origin, POINT axisEnd, POINT gridEnd) const {
+		Render::Pixel foreColor = Render::pixelFromColorRef(Style::getColor(color));
+		list.beginPath(foreColor, 2);
+		list.moveTo((float)origin.x, (float)origin.y);
+		list.lineTo((float)axisEnd.x, (float)axisEnd.y);
+
+		POINT gridAxis = { gridEnd.x - origin.x, gridEnd.y - origin.y };
+		float gridLength = sqrt(gridAxis.x * gridAxis.x + gridAxis.y * gridAxis.y);
+		POINT tick = { LONG(gridAxis.x / gridLength * SP_TICK_LENGTH), LONG(gridAxis.y / gridLength * SP_TICK_LENGTH) };
+
+		list.beginPath(foreColor, 1);
+		Ticks::TickSet const& ticks = tickCache.current();
+		for (double value : ticks.minor) {
+			POINT pos = getTickPosition(value, origin, axisEnd);
+			list.moveTo(float(pos.x - tick.x / 2), float(pos.y - tick.y / 2));
+			list.lineTo(float(pos.x + tick.x / 2), float(pos.y + tick.y / 2));
+		}
+		for (size_t i = 0; i < ticks.major.size(); i++) {
+			POINT pos = getTickPosition(ticks.major[i], origin, axisEnd);
+			if (pos.x != origin.x || pos.y != origin.y) {
+				list.moveTo(float(pos.x - tick.x), float(pos.y - tick.y));
+				list.lineTo(float(pos.x + tick.x), float(pos.y + tick.y));
+			}
+
+			// Numbers
+			std::wstring const& number = ticks.labels[i];
+			SIZE extent = Text::measure(number, tickFont);
+			list.drawMask(pos.x - LONG(extent.cx / 2), pos.y - LONG(extent.cy / 2), Text::rasterize(number, tickFont), foreColor);
+		}
+
+		// Box
+		list.beginPath(foreColor, 2);
+		list.moveTo((float)axisEnd.x, (float)axisEnd.y);
+		list.lineTo(float(axisEnd.x + gridAxis.x), float(axisEnd.y + gridAxis.y));
+		list.endPath();
+
+		// Axis label, drawn flat and turned to follow the axis
+		float angle = atan2(axisEnd.y - origin.y, axisEnd.x - origin.x);
+		int escapement = -angle * 180 / 3.14159265f * 10;
+		std::shared_ptr<Render::Mask const> labelMask = Text::rasterize(label, flatLabelFont, escapement);
+		if (labelMask) {
+			RECT labelRect = getLabelRect(origin, axisEnd, gridEnd);
+			list.drawMask((labelRect.left + labelRect.right - labelMask->width) / 2, (labelRect.top + labelRect.bottom - labelMask->height) / 2,
+				labelMask, foreColor);
+		}
+	}
+
+	void Axis::setLogarithmic(bool logarithmic_) {
+		logarithmic = logarithmic_;
+		updateTicks();
+	}
+
+	bool Axis::isLogarithmic() const {
+		return logarithmic;
+	}
+
+	void Axis::setNumberFormat(NUMBER_FORMAT format) {
+		numberFormat = format;
+		updateTicks();
+	}
+
+	void Axis::setTime(bool time_) {
+		time = time_;
+		if (!time) {
+			origin = 0;
+		}
+		updateTicks();
+	}
+
+	bool Axis::isTime() const {
+		return time;
+	}
+
+	void Axis::setOrigin(long long origin_) {
+		origin = origin_;
+		updateTicks();
+	}
+
+	long long Axis::getOrigin() const {
+		return origin;
+	}
+
+	void Axis::updateTicks() {
+		if (time) {
+			tickCache.updateTime(origin, minT, maxT, length);
+		}
+		else {
+			tickCache.update(minT, maxT, length, logarithmic, numberFormat);
+		}
+	}
+
+	void Axis::setLength(int pixels) {
+		length = pixels;
+		updateTicks();
+	}
+
+	POINT Axis::getTickPosition(double value, POINT origin, POINT axisEnd) const {
+		double frac = (value - minT) / (maxT - minT);
+		return { LONG(origin.x + frac * (axisEnd.x - origin.x)), LONG(origin.y + frac * (axisEnd.y - origin.y)) };
 	}
 
 
@@ -1,6 +1,8 @@
 #pragma once
 #include "standard.h"
 #include "colors.h"
+#include "ticks.h"
+#include "render/drawlist.h"
 #include <string>
 #include <windows.h>
 
@@ -10,34 +12,53 @@ namespace SimplePlot {
 	public:
 		Axis(std::string label = "", bool logarithmic = false, SimplePlot::Style::Color backColor = SimplePlot::Style::Color::WHITE,
 			SimplePlot::Style::Color color = SimplePlot::Style::Color::BLACK);
-		Axis(std::string label, float maxT, float minT, bool logarithmic = false, SimplePlot::Style::Color backColor = SimplePlot::Style::Color::WHITE,
+		Axis(std::string label, double maxT, double minT, bool logarithmic = false, SimplePlot::Style::Color backColor = SimplePlot::Style::Color::WHITE,
 			SimplePlot::Style::Color color = SimplePlot::Style::Color::BLACK);
 		~Axis();
+		Axis(Axis const&) = delete;
+		Axis& operator=(Axis const&) = delete;
 
-		bool setEnds(float minT_, float maxT_);
+		bool setEnds(double minT_, double maxT_);
+		void setLength(int pixels);
+		void setLogarithmic(bool logarithmic_);// Limits are then given as log10 of the data
+		bool isLogarithmic() const;
+		void setNumberFormat(NUMBER_FORMAT format);
+		void setTime(bool time_);// Data in nanoseconds since the Unix epoch; limits are then relative to the origin
+		bool isTime() const;
+		void setOrigin(long long origin_);
+		long long getOrigin() const;
 		int getClearance();
 		void drawGrid(HDC hdc, POINT origin, POINT axisEnd, POINT gridEnd);
 		void drawAxis(HDC hdc, POINT origin, POINT axisEnd, POINT gridEnd);
+		void recordGrid(Render::DrawList& list, POINT origin, POINT axisEnd, POINT gridEnd) const;
+		void recordAxis(Render::DrawList& list, POINT origin, POINT axisEnd, POINT gridEnd) const;
 
 		bool grid = true;
 
 	private:
-		void setMajorMinor();
+		POINT getTickPosition(double value, POINT origin, POINT axisEnd) const;
+		RECT getLabelRect(POINT origin, POINT axisEnd, POINT gridEnd) const;
 		void makePen();
+		void updateTicks();
 
 		bool logarithmic = false;
+		NUMBER_FORMAT numberFormat = NUMBER_FORMAT::AUTO;
+		bool time = false;
+		long long origin = 0;
 		bool fixEnds;
-		float maxT;
-		float minT;
-		float major;
-		float minor;
+		double maxT = 1;
+		double minT = 0;
+		int length = 0;// In pixels
+		Ticks::TickCache tickCache;
 		std::wstring label;
 		SimplePlot::Style::Color color;
 		SimplePlot::Style::Color backColor;
 		HPEN thickPen, thinPen, backPen;
 
-		HFONT labelFont;
+		HFONT labelFont = NULL;
+		int labelEscapement = 0;
 		HFONT tickFont;
+		HFONT flatLabelFont;// labelFont without the escapement, for the raster path
 	};
 
 	namespace Axes {
@@ -3,34 +3,47 @@
 #pragma warning(disable:4267)
 
 #include <shellscalingapi.h>
+#include <chrono>
+#include <memory>
 #include <thread>
 #include <algorithm>
+#include <cmath>
 
 #include "wndProc.h"
+#include "resources.h"
+#include "text.h"
 #include "plots/plot.h"
+#include "sketch.h"
+#include "locks.h"
+#include "trace.h"
 
 
 namespace SimplePlot {
 	namespace Maps {
 		std::map<CANVAS_ID, HWND> canvasHWNDMap;
 		std::map<CANVAS_ID, std::mutex> canvasMutexMap;
-		std::map<CANVAS_ID, SimplePlot::Canvas::Canvas*> canvasPointerMap;
+		std::map<CANVAS_ID, std::shared_ptr<SimplePlot::Canvas::Canvas>> canvasPointerMap;// Shared with callers mid-frame
 		std::mutex canvasMapMutex;
+		Locks::Site canvasGuardMapSite("CanvasGuard canvasMapMutex");
+		Locks::Site canvasGuardCanvasSite("CanvasGuard canvas mutex");
+		Locks::Site canvasRegistrySite("canvas registry canvasMapMutex");// Creating, deleting and listing canvases
+		Locks::Site canvasFrameSite("Canvas drawMutex");
 
 		class CanvasGuard {
 		public:
-			CanvasGuard(CANVAS_ID id) : generalGuard(Maps::canvasMapMutex), specificGuard(Maps::canvasMutexMap[id]) {}
+			CanvasGuard(CANVAS_ID id) : generalGuard(Maps::canvasMapMutex, canvasGuardMapSite),
+				specificGuard(Maps::canvasMutexMap[id], canvasGuardCanvasSite) {}
 
 		private:
-			std::lock_guard<std::mutex> generalGuard;
-			std::lock_guard<std::mutex> specificGuard;
+			Locks::LockGuard generalGuard;
+			Locks::LockGuard specificGuard;
 		};
 	}
 
 	namespace Canvas {
 		Canvas::Canvas(std::vector<PLOT_ID> plots_, std::wstring name, int style) : name(name), style(style) {
-			id = maxID;
-			maxID++;
+			id = maxID++;
+			textFont = Resources::acquireFont(L"Calibri", 24, 400);
 
 			if (plots_.size() == 0) { return; }
 			axisType = getPlotAxisType(plots_[0]);
@@ -48,10 +61,14 @@ namespace SimplePlot {
 		}
 
 		Canvas::~Canvas() {
+			leaveAxisLinks();
 			delete[] axisTitles;
 			delete[] axisLimits;
+			delete[] axisLinks;
+			delete[] autoscale;
 			delete[] drawSpace;
 			delete[] axes;
+			Resources::release(textFont);
 		}
 
 		void Canvas::initWindow() {
@@ -82,7 +99,7 @@ namespace SimplePlot {
 				NULL);
 			createBitmap();
 			
-			std::lock_guard<std::mutex> generalGuard(Maps::canvasMapMutex);
+			Locks::LockGuard generalGuard(Maps::canvasMapMutex, Maps::canvasRegistrySite);
 			Maps::canvasHWNDMap[id] = hwnd;
 
 			ShowWindow(hwnd, SW_SHOW);
@@ -100,18 +117,29 @@ namespace SimplePlot {
 					kill();
 					break;
 				}
-				paint();
-				if (PeekMessage(&messages, hwnd, 0, 0, PM_REMOVE)) {
-					TranslateMessage(&messages);
-					DispatchMessage(&messages);
+				{
+					Trace::Span span("frame", "canvas", id);
+					auto start = std::chrono::steady_clock::now();
+					Profile::FrameTimer timer(&profiler);
+					paint(timer);
+					if (PeekMessage(&messages, hwnd, 0, 0, PM_REMOVE)) {
+						TranslateMessage(&messages);
+						DispatchMessage(&messages);// Usually the WM_PAINT that blits the frame
+					}
+					timer.phase(Profile::PRESENT);
+					timer.finish();
+					detail.frame(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(), getFrameBudget());
 				}
 				std::this_thread::sleep_for(std::chrono::milliseconds(1000 / framerate));
 			}
 			DeleteObject(hwnd); // doing it just in case
-			delete this;
+			// The thread's own reference, and those of any callers still drawing, keep the canvas alive.
+			Locks::LockGuard generalGuard(Maps::canvasMapMutex, Maps::canvasRegistrySite);
+			Maps::canvasPointerMap.erase(id);
+			Maps::canvasMutexMap.erase(id);
 		}
 
-		void Canvas::paint() {
+		void Canvas::paint(Profile::FrameTimer& timer) {
 			std::lock_guard<std::mutex> guard(hwndToBitmapMutex);
 			HDC hdcScreen = GetDC(hwnd);
 			HDC hdcBmp = CreateCompatibleDC(hdcScreen);
@@ -126,11 +154,20 @@ namespace SimplePlot {
 			FillRect(hdcBmp, &r, style.backBrush);
 			SetBkMode(hdcBmp, TRANSPARENT);
 
-			draw(hdcBmp);
+			{
+				Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
+				draw(hdcBmp, timer);
+			}
 
 			SelectObject(hdcBmp, oldBrush);
 
 			DeleteDC(hdcBmp);
+			{
+				Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
+				if (recorder) {
+					captureFrame(hdcScreen, hwndToBitmap[hwnd], r.right - r.left, r.bottom - r.top);
+				}
+			}
 			ReleaseDC(NULL, hdcScreen);
 
 			InvalidateRect(hwnd, &r, FALSE);
@@ -143,6 +180,9 @@ namespace SimplePlot {
 			std::lock_guard<std::mutex> guard(hwndToBitmapMutex);
 			std::lock_guard<std::mutex> guard2(terminateCanvasMutex);
 			hwndToBitmap[hwnd] = CreateCompatibleBitmap(hdc, rc.right - rc.left, rc.bottom - rc.top);
+			bitmapBytes = 4LL * (rc.right - rc.left) * (rc.bottom - rc.top);
+			Memory::charge(Memory::CANVAS_OWNER, id, MEMORY_CATEGORY::BITMAPS, bitmapBytes);
+			Memory::chargeGDI(Memory::CANVAS_OWNER, id, 1);
 			terminateCanvas[hwnd] = false;
 		}
 
@@ -186,55 +226,47 @@ namespace SimplePlot {
 		}
 
 		void Canvas::addPlot(PLOT_ID plotID) {
+			// Leave the old canvas before waiting on this one's frame, so two canvases trading plots never each
+			// hold their own drawMutex while waiting on the other's.
 			CANVAS_ID originalCanvas = getPlotCanvas(plotID);
 			if (originalCanvas != SP_NULL_CANVAS) {
 				removePlotFromCanvas(originalCanvas, plotID);
 			}
+			// The axes may be rebuilt and the plot list reordered, neither of which a frame can survive.
+			Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
 			associatePlot(plotID, id);
 
+			if (getPlotType(plotID) == PLOT_TYPE::HISTOGRAM) {
+				// Histogram bars only make sense on linear axes; see setLogAxis.
+				for (int i = 0; i < numAxes; i++) {
+					if (!axes[i].isLogarithmic()) { continue; }
+					axes[i].setLogarithmic(false);
+					for (PLOT_ID other : plots) {
+						setPlotLogAxis(other, i, false);
+					}
+				}
+			}
+
 			if (plots.size() == 0) {
 				plots.push_back(plotID);
 				plotNames.push_back(getPlotName(plotID));
 				axisType = getPlotAxisType(plotID);
 				setAxisType();
+				applyAxisModes(plotID);
 				return;
 			}
+			applyAxisModes(plotID);
 
-			// Binary insert into a list which is sorted from greatest to least.
+			// Insert into a list which is sorted from greatest to least, after the plots of the same type. A canvas
+			// holds few enough plots that a linear search costs nothing.
 			int thisOrder = (int)getPlotType(plotID);
-			auto begin = plots.begin();
-			auto end = plots.end()-1;
-			int beginOrder = (int)getPlotType(*begin);
-			int endOrder = (int)getPlotType(*end);
-			while (beginOrder != endOrder) {
-				auto middle = (begin + std::distance(begin, end) / 2);
-				int middleOrder = (int)getPlotType(*middle);
-				if (middleOrder > thisOrder) {
-					begin = middle;
-					beginOrder = middleOrder;
-				}
-				else {
-					end = middle;
-					endOrder = middleOrder;
-				}
-			}
-			if (beginOrder != thisOrder) {
-				if (beginOrder < thisOrder) {
-					plotNames.insert(plotNames.begin() + int(begin - plots.begin()), getPlotName(plotID));
-					plots.insert(begin, plotID);
-				}
-				else {
-					plotNames.insert(plotNames.begin() + int(end + 1 - plots.begin()), getPlotName(plotID));
-					plots.insert(end + 1, plotID);
-				}
-			}
-			else {
-				plotNames.insert(plotNames.begin() + int(begin - plots.begin()), getPlotName(plotID));
-				plots.insert(begin, plotID);
-			}
+			auto it = std::find_if(plots.begin(), plots.end(), [thisOrder](PLOT_ID other) { return (int)getPlotType(other) < thisOrder; });
+			plotNames.insert(plotNames.begin() + int(it - plots.begin()), getPlotName(plotID));
+			plots.insert(it, plotID);
 		}
 
 		void Canvas::removePlot(PLOT_ID plotID) {
+			Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
 			auto it = std::find(plots.begin(), plots.end(), plotID);
 			if (it == plots.end()) {
 				// Plot is not in the canvas
@@ -246,6 +278,130 @@ namespace SimplePlot {
 
 		}
 
+		void Canvas::setLogAxis(int axisNum, bool logarithmic) {
+			if (axisNum < 0 || axisNum >= numAxes) { return; }
+			Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
+			if (logarithmic) {
+				for (PLOT_ID plotID : plots) {
+					if (getPlotType(plotID) == PLOT_TYPE::HISTOGRAM) { return; }
+				}
+			}
+			axes[axisNum].setLogarithmic(logarithmic);
+			for (PLOT_ID plotID : plots) {
+				setPlotLogAxis(plotID, axisNum, logarithmic);
+			}
+		}
+
+		void Canvas::setAxisFormat(int axisNum, NUMBER_FORMAT format) {
+			if (axisNum < 0 || axisNum >= numAxes) { return; }
+			Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
+			axes[axisNum].setNumberFormat(format);
+		}
+
+		void Canvas::setTimeAxis(int axisNum, bool time) {
+			if (axisNum < 0 || axisNum >= numAxes) { return; }
+			Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
+			axes[axisNum].setTime(time);
+			for (PLOT_ID plotID : plots) {
+				setPlotAxisOrigin(plotID, axisNum, axes[axisNum].getOrigin());
+			}
+		}
+
+		void Canvas::setAxisLink(int axisNum, LINK_ID link) {
+			if (axisNum < 0 || axisNum >= numAxes) { return; }
+			Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
+			if (std::shared_ptr<Link::AxisLink> old = Link::getLink(axisLinks[axisNum])) {
+				old->leave(id, axisNum);
+			}
+			axisLinks[axisNum] = link;
+		}
+
+		void Canvas::setAutoscale(int axisNum, double lowPercentile, double highPercentile) {
+			if (axisNum < 0 || axisNum >= numAxes || !(lowPercentile < highPercentile)) { return; }
+			Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
+			autoscale[axisNum * 2] = (std::max)(lowPercentile, 0.0) / 100;
+			autoscale[axisNum * 2 + 1] = (std::min)(highPercentile, 100.0) / 100;
+		}
+
+		bool Canvas::startRecording(std::wstring const& path, RECORDING_FORMAT format) {
+			stopRecording();
+			std::unique_ptr<Export::Recorder> next = std::make_unique<Export::Recorder>(path, format,
+				framerate == SP_STATIC ? SP_DEFAULT_FRAMERATE : framerate);
+			Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
+			if (next->getStats().failed) {
+				next->stop();
+				lastRecording = next->getStats();
+				return false;
+			}
+			recorder = std::move(next);
+			return true;
+		}
+
+		void Canvas::stopRecording() {
+			// Let go of drawMutex before waiting for the encoder, so the canvas keeps drawing meanwhile.
+			std::unique_ptr<Export::Recorder> finished;
+			{
+				Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
+				finished = std::move(recorder);
+			}
+			if (finished) {
+				finished->stop();
+				Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
+				lastRecording = finished->getStats();
+			}
+		}
+
+		RecordingStats Canvas::getRecordingStats() {
+			Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
+			return recorder ? recorder->getStats() : lastRecording;
+		}
+
+		void Canvas::leaveAxisLinks() {
+			if (!axisLinks) { return; }
+			for (int i = 0; i < numAxes; i++) {
+				if (std::shared_ptr<Link::AxisLink> link = Link::getLink(axisLinks[i])) {
+					link->leave(id, i);
+				}
+			}
+		}
+
+		void Canvas::applyAxisModes(PLOT_ID plotID) {
+			for (int i = 0; i < numAxes; i++) {
+				setPlotLogAxis(plotID, i, axes[i].isLogarithmic());
+				setPlotAxisOrigin(plotID, i, axes[i].getOrigin());
+			}
+		}
+
+		bool Canvas::updateTimeOrigins() {
+			// Epoch nanoseconds are too big for a double to hold exactly, so a time axis measures from an origin
+			// near its data. The origin only moves when the data strays far enough for that to stop working.
+			bool moved = false;
+			for (int i = 0; i < numAxes; i++) {
+				if (!axes[i].isTime()) { continue; }
+				double low = axisLimits[i * 2];
+				double high = axisLimits[i * 2 + 1];
+				if (!std::isfinite(low) || !std::isfinite(high)) { continue; }
+				// Measured from the low end, so a span wider than the offset limit settles once the origin sits
+				// just below its data rather than chasing the far end every frame.
+				if (std::abs(low) <= SP_MAX_TIME_OFFSET) { continue; }
+
+				// A whole second, so the origin itself never needs more than seconds to describe. The sum is
+				// taken in double and clamped, as an offset from an origin at one end of the range can reach
+				// past the other.
+				double target = (double)axes[i].getOrigin() + low;
+				target = (std::max)(-9.2e18, (std::min)(target, 9.2e18));
+				long long origin = (long long)target;
+				origin -= ((origin % 1000000000LL) + 1000000000LL) % 1000000000LL;
+				if (origin == axes[i].getOrigin()) { continue; }
+				axes[i].setOrigin(origin);
+				for (PLOT_ID plotID : plots) {
+					setPlotAxisOrigin(plotID, i, origin);
+				}
+				moved = true;
+			}
+			return moved;
+		}
+
 		void Canvas::setAxisType() {
 			switch (axisType) {
 			case AXIS_TYPE::CART_2D:
@@ -257,46 +413,113 @@ namespace SimplePlot {
 			}
 			numAxes = Axes::getNumAxes(axisType);
 			numCorners = Axes::getNumAxisCorners(axisType);
+			// Called again whenever the first plot is added, so drop the previous axes rather than leak them.
+			leaveAxisLinks();
+			delete[] axes;
+			delete[] axisTitles;
+			delete[] axisLimits;
+			delete[] axisLinks;
+			delete[] autoscale;
+			delete[] drawSpace;
 			axes = new Axis[numAxes];
 			axisTitles = new std::string[numAxes];
-			axisLimits = new float[numAxes * 2];
+			axisLimits = new double[numAxes * 2];
+			axisLinks = new LINK_ID[numAxes];
+			autoscale = new double[numAxes * 2];
+			for (int i = 0; i < numAxes; i++) {
+				axisLinks[i] = SP_NULL_LINK;
+				autoscale[i * 2] = 0;
+				autoscale[i * 2 + 1] = 1;
+			}
 			drawSpace = new POINT[numCorners];
 		}
 
-		void Canvas::draw(HDC hdc) {
+		void Canvas::updateLimits() {
+			// A dynamic canvas follows data edited in place, so it measures its plots afresh every frame. Linked
+			// canvases are given the extent measured here.
+			bool rescan = framerate != SP_STATIC;
 			for (int i = 0; i < plots.size(); i++) {
-				getPlotAxisLimits(plots[i], axisLimits, i==0);
+				getPlotAxisLimits(plots[i], axisLimits, i==0, rescan);
+			}
+			if (updateTimeOrigins()) {
+				// Again, now that the limits can be measured exactly
+				for (int i = 0; i < plots.size(); i++) {
+					getPlotAxisLimits(plots[i], axisLimits, i == 0, rescan);
+				}
+			}
+			for (int i = 0; i < numAxes; i++) {
+				if (autoscale[i * 2] <= 0 && autoscale[i * 2 + 1] >= 1) { continue; }
+				// The plots' sketches merge into one of everything on the canvas. Limits set on the plots
+				// themselves give way here.
+				Sketch::KllSketch merged;
+				for (PLOT_ID plotID : plots) {
+					mergePlotSketch(plotID, i, merged);
+				}
+				double low = merged.quantile(autoscale[i * 2]);
+				double high = merged.quantile(autoscale[i * 2 + 1]);
+				if (merged.count() > 0 && low < high) {
+					axisLimits[i * 2] = low;
+					axisLimits[i * 2 + 1] = high;
+				}
+			}
+			for (int i = 0; i < numAxes; i++) {
+				if (axisLinks[i] == SP_NULL_LINK) { continue; }
+				std::shared_ptr<Link::AxisLink> link = Link::getLink(axisLinks[i]);
+				if (link) {
+					link->share(id, i, axes[i].getOrigin(), axisLimits[i * 2], axisLimits[i * 2 + 1]);
+				}
+				else {
+					axisLinks[i] = SP_NULL_LINK;
+				}
 			}
 
 			axes[0].setEnds(axisLimits[0], axisLimits[1]);
 			axes[1].setEnds(axisLimits[2], axisLimits[3]);
+		}
 
-			axes[0].drawGrid(hdc, drawSpace[0], drawSpace[1], drawSpace[2]);
-			axes[1].drawGrid(hdc, drawSpace[0], drawSpace[2], drawSpace[1]);
-
-			POINT size = getSize();
+		void Canvas::layout(POINT size) {
 			int clearanceHoriz = axes[0].getClearance();
 			int clearanceVert = axes[1].getClearance();
 			drawSpace[0] = { clearanceVert, size.y - clearanceHoriz };
 			drawSpace[1] = { size.x - SP_BORDER_WIDTH, size.y - clearanceHoriz };
 			drawSpace[2] = { clearanceVert, SP_BORDER_WIDTH };
 			drawSpace[3] = { size.x - SP_BORDER_WIDTH, SP_BORDER_WIDTH };
+			axes[0].setLength(drawSpace[1].x - drawSpace[0].x);
+			axes[1].setLength(drawSpace[0].y - drawSpace[2].y);
+		}
+
+		void Canvas::draw(HDC hdc, Profile::FrameTimer& timer) {
+			timer.phase(Profile::PRESENT);// Clearing the bitmap
+			updateLimits();
+			timer.phase(Profile::LIMITS);
+			POINT size = getSize();
+			layout(size);
+
+			axes[0].drawGrid(hdc, drawSpace[0], drawSpace[1], drawSpace[2]);
+			axes[1].drawGrid(hdc, drawSpace[0], drawSpace[2], drawSpace[1]);
+			timer.phase(Profile::AXES);
 
+			int level = detail.getLevel();
 			for (PLOT_ID id : plots) {
-				drawPlot(id, hdc, axisLimits, drawSpace);
+				{
+					Trace::Span span("draw", "plot", id);
+					drawPlot(id, hdc, axisLimits, drawSpace, level);
+				}
+				timer.plot(id);
 			}
 			axes[0].drawAxis(hdc, drawSpace[0], drawSpace[1], drawSpace[2]);
 			axes[1].drawAxis(hdc, drawSpace[0], drawSpace[2], drawSpace[1]);
+			timer.phase(Profile::AXES);
 
+			HFONT oldFont = (HFONT)SelectObject(hdc, textFont);
 			RECT nameRect = { 0, 0, size.x, 80 };
 			DrawText(hdc, name.c_str(), name.size(), &nameRect, DT_CENTER);
 
 			if (legend) {
 				RECT legendRect = { SP_BORDER_WIDTH + 10, SP_BORDER_WIDTH + 10, 0, SP_BORDER_WIDTH + 40, };
-				for (std::wstring s : plotNames) {
-					RECT textRect = { 0, 0, 0, 0 };
-					DrawText(hdc, s.c_str(), s.size(), &textRect, DT_CALCRECT);
-					legendRect.right = legendRect.left + max(legendRect.right - legendRect.left, textRect.right);
+				for (std::wstring const& s : plotNames) {
+					SIZE extent = Text::measure(s, textFont);
+					legendRect.right = legendRect.left + max(legendRect.right - legendRect.left, extent.cx);
 				}
 				legendRect.right += 20;
 				for (int i = 0; i < plots.size(); i++) {
@@ -305,25 +528,178 @@ namespace SimplePlot {
 					legendRect.bottom += 30;
 				}
 			}
+			SelectObject(hdc, oldFont);
 
 			if (enforceSquare) {
 				POINT s = getSize();
 				int bufferx = SP_BORDER_WIDTH;/// I should fix these later; they're not totally correct.
 				int buffery = SP_BORDER_WIDTH;
-				float aspect = (axisLimits[1] - axisLimits[0]) / (axisLimits[3] - axisLimits[2]);// x / y
+				double aspect = (axisLimits[1] - axisLimits[0]) / (axisLimits[3] - axisLimits[2]);// x / y
 				if (1 / SP_MAX_ASPECT < aspect && aspect < SP_MAX_ASPECT) {
 					float scale = (s.x + s.y - bufferx - buffery) / (aspect + 1);
 					int parity = s.x + s.y - (int(bufferx + scale * aspect) + int(buffery + scale));
 					setSize(int(bufferx + scale * aspect) + parity, int(buffery + scale));
 				}
 			}
+			timer.phase(Profile::LEGEND);
 		}
 
-		void Canvas::kill() {
+		void Canvas::render(Render::Framebuffer& fb, bool parallel) {
+			Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
+			if (killed) { return; }// Deleted while the caller waited
+			Trace::Span span("frame", "canvas", id);
+			auto start = std::chrono::steady_clock::now();
+			Profile::FrameTimer timer(&profiler);
+			record({ fb.width, fb.height }, detail.getLevel(), parallel, timer);
+			{
+				Trace::Span rasterizeSpan("rasterize", "render", id);
+				rasterizer.rasterize(drawList, fb, parallel);
+			}
+			if (recorder) {
+				recorder->submitCopy(fb);
+			}
+			timer.phase(Profile::PRESENT);
+			timer.finish();
+			detail.frame(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(), getFrameBudget());
+		}
+
+		double Canvas::getFrameBudget() {
+			double budget = detail.getBudget();
+			if (budget < 0) {
+				// SP_FRAMERATE_BUDGET. A static canvas has no framerate to keep up with.
+				return framerate > 0 ? 1000.0 / framerate : 0;
+			}
+			return budget;
+		}
+
+		MemoryUsage Canvas::getMemoryUsage() {
+			MemoryUsage usage = Memory::getCharged(Memory::CANVAS_OWNER, id);
+			Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
+			usage.caches += drawList.bytes();
+			for (Render::DrawList const& layer : layers) {
+				usage.caches += layer.bytes();
+			}
+			usage.scratch += rasterizer.bytes();
+			if (recorder) {
+				usage.bitmaps += recorder->getBufferBytes();
+			}
+			return usage;
+		}
+
+		void Canvas::captureFrame(HDC hdc, HBITMAP bitmap, int width, int height) {
+			// The bitmap must not be selected into a DC here. GetDIBits writes straight into the recorder's buffer.
+			Render::Framebuffer* frame = recorder->acquire(width, height);
+			if (!frame) { return; }
+			BITMAPINFO info = { 0 };
+			info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+			info.bmiHeader.biWidth = width;
+			info.bmiHeader.biHeight = -height;// Top down
+			info.bmiHeader.biPlanes = 1;
+			info.bmiHeader.biBitCount = 32;
+			info.bmiHeader.biCompression = BI_RGB;
+			GetDIBits(hdc, bitmap, 0, height, frame->pixels.data(), &info, DIB_RGB_COLORS);
+			for (Render::Pixel& p : frame->pixels) {
+				p |= 0xff000000u;// GDI leaves the alpha byte undefined
+			}
+			recorder->submit(frame);
+		}
+
+		void Canvas::renderSVG(Export::Sink sink, int width, int height, float tolerance) {
+			Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
 			if (killed) { return; }
+			Trace::Span span("frame", "canvas", id);
+			Profile::FrameTimer timer(&profiler);
+			record({ width, height }, 0, true, timer);
+			Export::writeSVG(drawList, width, height, tolerance, sink);
+			timer.phase(Profile::PRESENT);
+			timer.finish();
+		}
+
+		void Canvas::record(POINT size, int level, bool parallel, Profile::FrameTimer& timer) {
+			// Fills drawList with a frame of the given size and level of detail. The caller holds drawMutex.
+			drawList.clear();
+			drawList.fillRect(0, 0, (float)size.x, (float)size.y, Render::pixelFromColorRef(style.backBrushColor));
+			if (plots.size() == 0) {
+				return;
+			}
+			updateLimits();
+			timer.phase(Profile::LIMITS);
+			layout(size);
+
+			axes[0].recordGrid(drawList, drawSpace[0], drawSpace[1], drawSpace[2]);
+			axes[1].recordGrid(drawList, drawSpace[0], drawSpace[2], drawSpace[1]);
+			timer.phase(Profile::AXES);
+
+			recordPlots(level, parallel, timer);
+			axes[0].recordAxis(drawList, drawSpace[0], drawSpace[1], drawSpace[2]);
+			axes[1].recordAxis(drawList, drawSpace[0], drawSpace[2], drawSpace[1]);
+			timer.phase(Profile::AXES);
+
+			Render::Pixel textColor = Render::pixelFromColorRef(Style::getColor(Style::Color::BLACK));
+			std::shared_ptr<Render::Mask const> nameMask = Text::rasterize(name, textFont);
+			if (nameMask) {
+				drawList.drawMask((size.x - nameMask->width) / 2, 0, nameMask, textColor);
+			}
+
+			if (legend) {
+				RECT legendRect = { SP_BORDER_WIDTH + 10, SP_BORDER_WIDTH + 10, 0, SP_BORDER_WIDTH + 40, };
+				for (int i = 0; i < plots.size(); i++) {
+					recordPlotLegend(plots[i], drawList, legendRect);
+					drawList.drawMask(legendRect.left + 20, legendRect.top, Text::rasterize(plotNames[i], textFont), textColor);
+					legendRect.top += 30;
+					legendRect.bottom += 30;
+				}
+			}
+			timer.phase(Profile::LEGEND);
+		}
+
+		void Canvas::recordPlots(int level, bool parallel, Profile::FrameTimer& timer) {
+			if (!parallel || plots.size() < 2) {
+				for (PLOT_ID id : plots) {
+					{
+						Trace::Span span("record", "plot", id);
+						recordPlot(id, drawList, axisLimits, drawSpace, level);
+					}
+					timer.plot(id);
+				}
+				return;
+			}
+
+			// Each plot records into its own layer, and the layers are appended in depth order, so the draw list
+			// comes out the same as when the plots record one after another. The layers keep their capacity
+			// between frames.
+			layers.resize(plots.size());
+			std::vector<long long> times(plots.size());
+			SimplePlot::recordPlots(plots, layers.data(), times.data(), axisLimits, drawSpace, level);
+			for (size_t i = 0; i < plots.size(); i++) {
+				drawList.append(std::move(layers[i]));
+				timer.plot(plots[i], times[i]);
+			}
+			timer.skip();
+		}
+
+		void Canvas::kill() {
+			// Both paths wait out a frame in progress, taking drawMutex in the same order as paint.
+			if (offscreen) {
+				Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
+				if (killed) { return; }
+				for (PLOT_ID id : plots) {
+					if (framerate == SP_STATIC) {
+						deletePlotData(id);
+					}
+					disassociatePlot(id);
+				}
+				killed = true;
+				return;
+			}
 			std::lock_guard<std::mutex> guard(hwndToBitmapMutex);
 			std::lock_guard<std::mutex> guard2(terminateCanvasMutex);
+			Locks::LockGuard frameGuard(drawMutex, Maps::canvasFrameSite);
+			if (killed) { return; }
 			DeleteObject(hwndToBitmap[hwnd]);
+			Memory::charge(Memory::CANVAS_OWNER, id, MEMORY_CATEGORY::BITMAPS, -bitmapBytes);
+			Memory::chargeGDI(Memory::CANVAS_OWNER, id, -1);
+			bitmapBytes = 0;
 			terminateCanvas[hwnd] = true;
 			if (framerate == SP_STATIC) {
 				for (PLOT_ID id : plots) {
@@ -345,30 +721,166 @@ namespace SimplePlot {
 	}
 
 
+	namespace {
+		// The registry, the window thread and callers part way through a frame each hold a reference, so a
+		// canvas is only destroyed once the last of them lets go.
+		std::shared_ptr<Canvas::Canvas> share(Canvas::Canvas* canvas) {
+			return std::shared_ptr<Canvas::Canvas>(canvas, [](Canvas::Canvas* c) {
+				CANVAS_ID id = c->id;
+				delete c;
+				Memory::close(Memory::CANVAS_OWNER, id);
+			});
+		}
+	}
+
 	CANVAS_ID makeCanvas(std::vector<PLOT_ID> plots, std::wstring name, int style) {
 		// Spawn the update function in a new thread.
-		Canvas::Canvas* canvas = new Canvas::Canvas(plots, name, style);
+		std::shared_ptr<Canvas::Canvas> canvas = share(new Canvas::Canvas(plots, name, style));
 		std::thread(&Canvas::Canvas::launch, canvas).detach();
 		CANVAS_ID id = canvas->id;
-		std::lock_guard<std::mutex> generalGuard(Maps::canvasMapMutex);
+		Locks::LockGuard generalGuard(Maps::canvasMapMutex, Maps::canvasRegistrySite);
+		Maps::canvasMutexMap[id];
+		Maps::canvasPointerMap[id] = canvas;
+		return id;
+	}
+
+	CANVAS_ID makeOffscreenCanvas(std::vector<PLOT_ID> plots, std::wstring name, int style) {
+		// No window and no update thread: the canvas is only drawn by renderCanvas.
+		std::shared_ptr<Canvas::Canvas> canvas = share(new Canvas::Canvas(plots, name, style));
+		canvas->offscreen = true;
+		CANVAS_ID id = canvas->id;
+		Locks::LockGuard generalGuard(Maps::canvasMapMutex, Maps::canvasRegistrySite);
 		Maps::canvasMutexMap[id];
 		Maps::canvasPointerMap[id] = canvas;
 		return id;
 	}
 
+	void renderCanvas(CANVAS_ID id, Render::Framebuffer& fb, bool parallel) {
+		std::shared_ptr<Canvas::Canvas> ptr;
+		{
+			Maps::CanvasGuard guard(id);
+			ptr = Maps::canvasPointerMap.at(id);
+		}
+		// The canvas serializes its own frames; don't hold the registry locks while rasterizing.
+		ptr->render(fb, parallel);
+	}
+
+	bool startCanvasRecording(CANVAS_ID id, std::wstring const& path, RECORDING_FORMAT format) {
+		std::shared_ptr<Canvas::Canvas> ptr;
+		{
+			Maps::CanvasGuard guard(id);
+			ptr = Maps::canvasPointerMap.at(id);
+		}
+		return ptr->startRecording(path, format);
+	}
+
+	void stopCanvasRecording(CANVAS_ID id) {
+		std::shared_ptr<Canvas::Canvas> ptr;
+		{
+			Maps::CanvasGuard guard(id);
+			ptr = Maps::canvasPointerMap.at(id);
+		}
+		ptr->stopRecording();
+	}
+
+	void setCanvasProfiling(CANVAS_ID id, bool enabled) {
+		Maps::CanvasGuard guard(id);
+		Maps::canvasPointerMap.at(id)->profiler.setEnabled(enabled);
+	}
+
+	FrameStats getCanvasFrameStats(CANVAS_ID id) {
+		std::shared_ptr<Canvas::Canvas> ptr;
+		{
+			Maps::CanvasGuard guard(id);
+			ptr = Maps::canvasPointerMap.at(id);
+		}
+		// The ring is read without locks, so this never waits for a frame in progress.
+		return ptr->profiler.getStats();
+	}
+
+	void setCanvasFrameBudget(CANVAS_ID id, double milliseconds) {
+		Maps::CanvasGuard guard(id);
+		Maps::canvasPointerMap.at(id)->detail.setBudget(milliseconds);
+	}
+
+	DetailStats getCanvasDetail(CANVAS_ID id) {
+		Maps::CanvasGuard guard(id);
+		Canvas::Canvas* ptr = Maps::canvasPointerMap.at(id).get();
+		return ptr->detail.getStats(ptr->getFrameBudget());
+	}
+
+	RecordingStats getCanvasRecordingStats(CANVAS_ID id) {
+		std::shared_ptr<Canvas::Canvas> ptr;
+		{
+			Maps::CanvasGuard guard(id);
+			ptr = Maps::canvasPointerMap.at(id);
+		}
+		// Waits for a frame in progress, so not under the registry locks
+		return ptr->getRecordingStats();
+	}
+
+	void renderCanvasSVG(CANVAS_ID id, Export::Sink sink, int width, int height, float tolerance) {
+		std::shared_ptr<Canvas::Canvas> ptr;
+		{
+			Maps::CanvasGuard guard(id);
+			ptr = Maps::canvasPointerMap.at(id);
+		}
+		ptr->renderSVG(sink, width, height, tolerance);
+	}
+
 	void deleteCanvas(CANVAS_ID id) {
+		std::shared_ptr<Canvas::Canvas> offscreenCanvas;
+		{
+			Locks::LockGuard generalGuard(Maps::canvasMapMutex, Maps::canvasRegistrySite);
+			auto it = Maps::canvasPointerMap.find(id);
+			if (it != Maps::canvasPointerMap.end() && it->second->offscreen) {
+				offscreenCanvas = it->second;
+				Maps::canvasPointerMap.erase(it);
+				Maps::canvasMutexMap.erase(id);// Only ever held together with canvasMapMutex
+			}
+		}
+		if (offscreenCanvas) {
+			// kill waits for a frame in progress, and frames that start later draw nothing. Whoever lets go of
+			// the canvas last destroys it.
+			offscreenCanvas->kill();
+			return;
+		}
+
 		std::lock_guard<std::mutex> g(terminateCanvasMutex);
 		terminateCanvas.at(Maps::canvasHWNDMap.at(id)) = true;
 	}
 
+	std::vector<CanvasMemory> getCanvasMemoryUsage() {
+		// Each canvas waits for its frame in progress, so take a snapshot and measure them with the registry free.
+		std::vector<std::pair<CANVAS_ID, std::shared_ptr<Canvas::Canvas>>> canvases;
+		{
+			Locks::LockGuard generalGuard(Maps::canvasMapMutex, Maps::canvasRegistrySite);
+			canvases.assign(Maps::canvasPointerMap.begin(), Maps::canvasPointerMap.end());
+		}
+		std::vector<CanvasMemory> usage;
+		for (auto const& entry : canvases) {
+			usage.push_back({ entry.first, entry.second->getMemoryUsage() });
+		}
+		return usage;
+	}
+
 	void addPlotToCanvas(CANVAS_ID canvasID, PLOT_ID plotID) {
-		Maps::CanvasGuard guard(canvasID);
-		Maps::canvasPointerMap.at(canvasID)->addPlot(plotID);
+		std::shared_ptr<Canvas::Canvas> ptr;
+		{
+			Maps::CanvasGuard guard(canvasID);
+			ptr = Maps::canvasPointerMap.at(canvasID);
+		}
+		// Waits for a frame, and may take the guard of the plot's old canvas, so not under the registry locks
+		ptr->addPlot(plotID);
 	}
 
 	void removePlotFromCanvas(CANVAS_ID canvasID, PLOT_ID plotID) {
-		Maps::CanvasGuard guard(canvasID);
-		Maps::canvasPointerMap.at(canvasID)->removePlot(plotID);
+		std::shared_ptr<Canvas::Canvas> ptr;
+		{
+			Maps::CanvasGuard guard(canvasID);
+			ptr = Maps::canvasPointerMap.at(canvasID);
+		}
+		ptr->removePlot(plotID);
 	}
 
 	void setCanvasGridLines(CANVAS_ID canvasID, bool state) {
@@ -386,7 +898,52 @@ namespace SimplePlot {
 	}
 	void setCanvasEnforceSquare(CANVAS_ID id, bool sq) {
 		Maps::CanvasGuard guard(id);// Necessary?
-		Canvas::Canvas* ptr = Maps::canvasPointerMap.at(id);
-		ptr->enforceSquare = sq;
+		Maps::canvasPointerMap.at(id)->enforceSquare = sq;
+	}
+
+	void setCanvasLogAxis(CANVAS_ID id, int axisNum, bool logarithmic) {
+		std::shared_ptr<Canvas::Canvas> ptr;
+		{
+			Maps::CanvasGuard guard(id);
+			ptr = Maps::canvasPointerMap.at(id);
+		}
+		// These wait for a frame in progress, so they mustn't hold up the registry meanwhile.
+		ptr->setLogAxis(axisNum, logarithmic);
+	}
+
+	void setCanvasAxisFormat(CANVAS_ID id, int axisNum, NUMBER_FORMAT format) {
+		std::shared_ptr<Canvas::Canvas> ptr;
+		{
+			Maps::CanvasGuard guard(id);
+			ptr = Maps::canvasPointerMap.at(id);
+		}
+		ptr->setAxisFormat(axisNum, format);
+	}
+
+	void setCanvasTimeAxis(CANVAS_ID id, int axisNum, bool time) {
+		std::shared_ptr<Canvas::Canvas> ptr;
+		{
+			Maps::CanvasGuard guard(id);
+			ptr = Maps::canvasPointerMap.at(id);
+		}
+		ptr->setTimeAxis(axisNum, time);
+	}
+
+	void setCanvasAxisLink(CANVAS_ID id, int axisNum, LINK_ID link) {
+		std::shared_ptr<Canvas::Canvas> ptr;
+		{
+			Maps::CanvasGuard guard(id);
+			ptr = Maps::canvasPointerMap.at(id);
+		}
+		ptr->setAxisLink(axisNum, link);
+	}
+
+	void setCanvasAutoscale(CANVAS_ID id, int axisNum, double lowPercentile, double highPercentile) {
+		std::shared_ptr<Canvas::Canvas> ptr;
+		{
+			Maps::CanvasGuard guard(id);
+			ptr = Maps::canvasPointerMap.at(id);
+		}
+		ptr->setAutoscale(axisNum, lowPercentile, highPercentile);
 	}
 }
\ No newline at end of file
@@ -1,10 +1,21 @@
 #pragma once
 #include <windows.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 #include "standard.h"
 #include "axis.h"
+#include "detail.h"
+#include "link.h"
+#include "memory.h"
+#include "profile.h"
+#include "render/framebuffer.h"
+#include "render/rasterizer.h"
+#include "export/svg.h"
+#include "export/recorder.h"
 
 namespace SimplePlot {
 	namespace Canvas {
@@ -23,25 +34,48 @@ namespace SimplePlot {
 			void addPlot(PLOT_ID plotID);
 			void removePlot(PLOT_ID plotID);
 			void launch();
+			void kill();
+			void render(Render::Framebuffer& fb, bool parallel);
+			void renderSVG(Export::Sink sink, int width, int height, float tolerance);
 			bool isEmpty();
 			void setGridLines(bool state);
+			void setLogAxis(int axisNum, bool logarithmic);
+			void setAxisFormat(int axisNum, NUMBER_FORMAT format);
+			void setTimeAxis(int axisNum, bool time);
+			void setAxisLink(int axisNum, LINK_ID link);
+			void setAutoscale(int axisNum, double lowPercentile, double highPercentile);
+			bool startRecording(std::wstring const& path, RECORDING_FORMAT format);
+			void stopRecording();
+			RecordingStats getRecordingStats();
+			MemoryUsage getMemoryUsage();
+			double getFrameBudget();// Milliseconds, with SP_FRAMERATE_BUDGET resolved
 
 			std::string title;
 
-			HWND hwnd;
+			HWND hwnd = NULL;
 			CANVAS_ID id = SP_NULL_CANVAS;
 			bool legend = false;
 			bool enforceSquare = false;
+			bool offscreen = false;
+			Profile::FrameProfiler profiler;
+			Detail::Governor detail;
 
 		private:
 			void initWindow();
-			void paint();
-			void draw(HDC hdc);
+			void paint(Profile::FrameTimer& timer);
+			void draw(HDC hdc, Profile::FrameTimer& timer);
+			void record(POINT size, int level, bool parallel, Profile::FrameTimer& timer);
+			void recordPlots(int level, bool parallel, Profile::FrameTimer& timer);
+			void captureFrame(HDC hdc, HBITMAP bitmap, int width, int height);
+			void updateLimits();
+			void layout(POINT size);
 			void createBitmap();
 			void setAxisType();
-			void kill();
+			void applyAxisModes(PLOT_ID plotID);
+			bool updateTimeOrigins();
+			void leaveAxisLinks();
 
-			inline static CANVAS_ID maxID;
+			inline static std::atomic<CANVAS_ID> maxID = 0;// Batches create canvases from several threads at once
 
 			std::vector<PLOT_ID> plots;
 			int framerate = SP_DYNAMIC;
@@ -49,24 +83,62 @@ namespace SimplePlot {
 
 			int numAxes = 0;
 			int numCorners = 0;
-			std::string* axisTitles;
-			Axis* axes;
-			float* axisLimits;
-			POINT* drawSpace;
+			std::string* axisTitles = nullptr;
+			Axis* axes = nullptr;
+			double* axisLimits = nullptr;
+			LINK_ID* axisLinks = nullptr;// Per axis, or SP_NULL_LINK
+			double* autoscale = nullptr;// Per axis, the fractions of the data that autoscale puts at each end
+			POINT* drawSpace = nullptr;
 			std::wstring name;
 			std::vector<std::wstring> plotNames;
 
 			bool killed = false;
 			SimplePlot::Style::Style style;
+			HFONT textFont = NULL;// Title and legend
+
+			std::mutex drawMutex;// Held for the duration of a frame, on screen or off
+			Render::DrawList drawList;
+			std::vector<Render::DrawList> layers;// One per plot, recorded side by side and then appended to drawList
+			Render::Rasterizer rasterizer;
+			std::unique_ptr<Export::Recorder> recorder;// Guarded by drawMutex
+			RecordingStats lastRecording;
+			long long bitmapBytes = 0;// The window's back buffer, charged to the canvas
 		};
 	}
 
 	CANVAS_ID makeCanvas(std::vector<PLOT_ID> plots, std::wstring name = L"", int style = 0);
+	CANVAS_ID makeOffscreenCanvas(std::vector<PLOT_ID> plots, std::wstring name = L"", int style = 0);
+	void renderCanvas(CANVAS_ID id, Render::Framebuffer& fb, bool parallel = true);
+	void renderCanvasSVG(CANVAS_ID id, Export::Sink sink, int width, int height, float tolerance = SP_SVG_TOLERANCE);
 	void deleteCanvas(CANVAS_ID id);
+	std::vector<CanvasMemory> getCanvasMemoryUsage();
 	void addPlotToCanvas(CANVAS_ID canvasID, PLOT_ID plotID);
 	void removePlotFromCanvas(CANVAS_ID canvasID, PLOT_ID plotID);
 	void setCanvasGridLines(CANVAS_ID canvasID, bool state);
 	void setCanvasFramerate(CANVAS_ID id, int framerate);
 	void setCanvasLegend(CANVAS_ID id, bool legend);
 	void setCanvasEnforceSquare(CANVAS_ID id, bool sq);
+	// axisNum: SP_X_AXIS, SP_Y_AXIS. Ignored on a canvas holding a histogram, whose bins and counts are always drawn
+	// linearly; adding a histogram turns the canvas's log axes back to linear.
+	void setCanvasLogAxis(CANVAS_ID id, int axisNum, bool logarithmic);
+	void setCanvasAxisFormat(CANVAS_ID id, int axisNum, NUMBER_FORMAT format);
+	void setCanvasTimeAxis(CANVAS_ID id, int axisNum, bool time);// Data on the axis is int64 nanoseconds since the epoch
+	void setCanvasAxisLink(CANVAS_ID id, int axisNum, LINK_ID link);// SP_NULL_LINK gives the axis back its own range
+	// Fit the axis to percentiles of the data instead of its extremes, e.g. 0.1 and 99.9, so that a few wild
+	// values don't squash the rest. 0 and 100 give the usual fit.
+	void setCanvasAutoscale(CANVAS_ID id, int axisNum, double lowPercentile, double highPercentile);
+	// Copy every frame the canvas draws, on screen or through renderCanvas, to a file. Encoding happens on its own
+	// thread; frames that arrive while SP_RECORDING_QUEUE are still waiting are dropped rather than delaying the
+	// canvas. Starting again replaces the current recording.
+	bool startCanvasRecording(CANVAS_ID id, std::wstring const& path, RECORDING_FORMAT format);// false if the file can't be opened
+	void stopCanvasRecording(CANVAS_ID id);// Returns once the file is complete
+	RecordingStats getCanvasRecordingStats(CANVAS_ID id);// Of the current recording, or the last one once stopped
+	// Time each frame's phases and plots. Off by default; when off, the cost is a branch per phase.
+	void setCanvasProfiling(CANVAS_ID id, bool enabled);
+	FrameStats getCanvasFrameStats(CANVAS_ID id);
+	// Keep frames within a budget by drawing dense lines with less detail while frames run long, and with more
+	// again once there is headroom. SP_FRAMERATE_BUDGET follows the canvas's framerate; 0, the default, always
+	// draws every point. SVG exports are always drawn in full.
+	void setCanvasFrameBudget(CANVAS_ID id, double milliseconds);
+	DetailStats getCanvasDetail(CANVAS_ID id);
 }
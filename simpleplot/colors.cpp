@@ -1,4 +1,5 @@
 #include "colors.h"
+#include "resources.h"
 #include <Windows.h>
 
 typedef unsigned char BYTE;
@@ -39,10 +40,6 @@ namespace SimplePlot::Style {
 	}
 
 	Style::Style(int s) {
-		COLORREF forePenColor;
-		COLORREF backPenColor;
-		COLORREF foreBrushColor;
-		COLORREF backBrushColor;
 		switch (s % 16) {
 		default:
 		case SP_BLACK:
@@ -97,19 +94,47 @@ namespace SimplePlot::Style {
 			thickness = 3; break;
 		}
 
-		foreBrush = CreateSolidBrush(foreBrushColor);
-		backBrush = CreateSolidBrush(backBrushColor);
-		forePen = CreatePen(style, thickness, forePenColor);
-		backPen = CreatePen(PS_SOLID, 2, backPenColor);
+		foreBrush = Resources::acquireBrush(foreBrushColor);
+		backBrush = Resources::acquireBrush(backBrushColor);
+		forePen = Resources::acquirePen(style, thickness, forePenColor);
+		backPen = Resources::acquirePen(PS_SOLID, 2, backPenColor);
 		foreStyle = ((s / 16) % 16) * 16;
+		foreWidth = thickness;
+	}
+
+	Style::Style(Style const& other) {
+		*this = other;
+	}
+
+	Style& Style::operator=(Style const& other) {
+		if (this == &other) { return *this; }
+		// Take the new references before dropping the old ones, in case both styles share handles.
+		Resources::retain(other.foreBrush);
+		Resources::retain(other.backBrush);
+		Resources::retain(other.forePen);
+		Resources::retain(other.backPen);
+		Resources::release(foreBrush);
+		Resources::release(backBrush);
+		Resources::release(forePen);
+		Resources::release(backPen);
+
+		foreBrush = other.foreBrush;
+		backBrush = other.backBrush;
+		forePen = other.forePen;
+		backPen = other.backPen;
+		foreStyle = other.foreStyle;
+		foreWidth = other.foreWidth;
+		forePenColor = other.forePenColor;
+		backPenColor = other.backPenColor;
+		foreBrushColor = other.foreBrushColor;
+		backBrushColor = other.backBrushColor;
+		return *this;
 	}
 
 	Style::~Style() {
-		if (foreBrush != NULL) {
-			DeleteObject(foreBrush);
-			DeleteObject(backBrush);
-			DeleteObject(forePen);
-			DeleteObject(backPen);
-		}
+		Resources::release(foreBrush);
+		Resources::release(backBrush);
+		Resources::release(forePen);
+		Resources::release(backPen);
 	}
 }
\ No newline at end of file
@@ -44,6 +44,8 @@ namespace SimplePlot {
 		public:
 			Style() {}
 			Style(int);
+			Style(Style const& other);
+			Style& operator=(Style const& other);
 
 			~Style();
 
@@ -53,6 +55,12 @@ namespace SimplePlot {
 			HPEN forePen = NULL;
 			HPEN backPen = NULL;
 			int foreStyle;
+			int foreWidth;
+
+			SP_COLORREF forePenColor;
+			SP_COLORREF backPenColor;
+			SP_COLORREF foreBrushColor;
+			SP_COLORREF backBrushColor;
 		};
 	}
 }
\ No newline at end of file
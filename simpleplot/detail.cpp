@@ -0,0 +1,86 @@
+#include "detail.h"
+
+
+namespace SimplePlot::Detail {
+	bool shadesDensity(int level, int points, POINT const* drawSpace) {
+		long long columns = (std::max)(drawSpace[1].x - drawSpace[0].x, 1L);
+		return level >= SP_DETAIL_DENSITY && points > columns * SP_DETAIL_DENSE;
+	}
+
+	int decimationLevel(int level) {
+		return (std::min)(level, SP_DETAIL_DENSITY - 1);
+	}
+
+	DensityShader::DensityShader(POINT const* drawSpace, Render::Pixel color)
+		: left(drawSpace[0].x), top(drawSpace[2].y), right(drawSpace[1].x), bottom(drawSpace[0].y), color(color & 0x00ffffff) {
+		width = (std::max)(right - left, 0);
+		counts.assign((size_t)width * (std::max)(bottom - top, 0), 0);
+	}
+
+	Render::Image DensityShader::finish() {
+		Render::Image image;
+		image.left = left;
+		image.top = top;
+		image.width = width;
+		image.height = width ? (int)(counts.size() / width) : 0;
+		uint32_t most = 0;
+		for (uint32_t c : counts) {
+			most = (std::max)(most, c);
+		}
+		if (most == 0) {
+			image.width = image.height = 0;
+			return image;
+		}
+
+		// The faintest pixel a line passes through stays visible.
+		double scale = 191 / std::log1p((double)most);
+		image.pixels.resize(counts.size());
+		for (size_t p = 0; p < counts.size(); p++) {
+			unsigned int alpha = counts[p] ? 64 + (unsigned int)(std::log1p((double)counts[p]) * scale) : 0;
+			image.pixels[p] = color | (alpha << 24);
+		}
+		return image;
+	}
+
+	void Governor::setBudget(double milliseconds) {
+		std::lock_guard<std::mutex> guard(updateMutex);
+		budget.store(milliseconds, std::memory_order_relaxed);
+		if (milliseconds == 0) { level.store(0, std::memory_order_relaxed); }
+	}
+
+	void Governor::frame(double milliseconds, double effectiveBudget) {
+		std::lock_guard<std::mutex> guard(updateMutex);
+		double smoothed = frameTime.load(std::memory_order_relaxed);
+		frameTime.store(smoothed == 0 ? milliseconds : smoothed + (milliseconds - smoothed) * 0.25, std::memory_order_relaxed);
+		if (effectiveBudget <= 0) {
+			level.store(0, std::memory_order_relaxed);
+			underBudget = 0;
+			return;
+		}
+
+		// Coarser at once, since every late frame shows, but finer only after a run of fast frames, since each
+		// level costs roughly twice the one above it and stepping straight back would overshoot.
+		int current = level.load(std::memory_order_relaxed);
+		if (milliseconds > effectiveBudget) {
+			underBudget = 0;
+			if (current < SP_DETAIL_DENSITY) { level.store(current + 1, std::memory_order_relaxed); }
+		}
+		else if (milliseconds <= effectiveBudget * SP_DETAIL_HEADROOM && current > 0) {
+			if (++underBudget >= SP_DETAIL_SETTLE) {
+				underBudget = 0;
+				level.store(current - 1, std::memory_order_relaxed);
+			}
+		}
+		else {
+			underBudget = 0;
+		}
+	}
+
+	DetailStats Governor::getStats(double effectiveBudget) const {
+		DetailStats stats;
+		stats.level = level.load(std::memory_order_relaxed);
+		stats.budget = (std::max)(effectiveBudget, 0.0);
+		stats.frameTime = frameTime.load(std::memory_order_relaxed);
+		return stats;
+	}
+}
\ No newline at end of file
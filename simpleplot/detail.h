@@ -0,0 +1,137 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <windows.h>
+
+#include "standard.h"
+#include "render/drawlist.h"
+
+
+namespace SimplePlot {
+	struct DetailStats {
+		int level = 0;// 0 draws every point; see SP_DETAIL_DENSITY
+		double budget = 0;// Milliseconds per frame, or 0 when the canvas always draws every point
+		double frameTime = 0;// Milliseconds, averaged over recent frames
+	};
+
+	namespace Detail {
+		// Which points a line keeps at each level: every point at level 0, and from level 1 on only the first,
+		// lowest, highest and last point of each bucket of consecutive points that fall in the same span of
+		// pixel columns. A bucket is 1 pixel wide at level 1 and doubles with each level, so level 1 is hard to
+		// tell from full detail while drawing at most four points per column.
+		template<typename Emit>
+		class Decimator {
+		public:
+			// emit(x, y, move) is called for every point kept, with move set where the line starts again.
+			Decimator(int level, Emit emit) : width(level > 0 ? float(1 << (level - 1)) : 0), emit(emit) {}
+
+			// Non-finite coordinates break the line.
+			void add(float x, float y) {
+				if (!std::isfinite(x) || !std::isfinite(y)) {
+					flush();
+					lifted = true;
+					return;
+				}
+				if (width == 0) {
+					emit(x, y, lifted);
+					lifted = false;
+					return;
+				}
+				long long column = (long long)std::floor(x / width);
+				if (open && column == bucket) {
+					count++;
+					last = { x, y, count };
+					if (y < low.y) { low = last; }
+					if (y > high.y) { high = last; }
+					return;
+				}
+				flush();
+				open = true;
+				bucket = column;
+				count = 0;
+				first = low = high = last = { x, y, 0 };
+			}
+
+			void finish() {
+				flush();
+			}
+
+		private:
+			struct Kept {
+				float x, y;
+				int index;// Within the bucket
+			};
+
+			void flush() {
+				if (!open) { return; }
+				open = false;
+				emit(first.x, first.y, lifted);
+				lifted = false;
+				Kept rest[3] = { low, high, last };
+				if (rest[0].index > rest[1].index) { std::swap(rest[0], rest[1]); }
+				int previous = 0;
+				for (Kept const& k : rest) {
+					if (k.index > previous) {
+						emit(k.x, k.y, false);
+						previous = k.index;
+					}
+				}
+			}
+
+			float width;// Pixels per bucket, or 0 to keep every point
+			Emit emit;
+			bool lifted = true;
+			bool open = false;
+			long long bucket = 0;
+			int count = 0;
+			Kept first = {}, low = {}, high = {}, last = {};
+		};
+
+		// Whether a line of this many points is drawn as density shading at this level. Lines with few points
+		// per column would lose their shape, so they stay at the coarsest decimation instead.
+		bool shadesDensity(int level, int points, POINT const* drawSpace);
+		int decimationLevel(int level);// The level to decimate at, for lines that don't shade
+
+		// Counts points per pixel over the plot area, then shades each pixel in the line's colour with an opacity
+		// that rises with the log of its count.
+		class DensityShader {
+		public:
+			DensityShader(POINT const* drawSpace, Render::Pixel color);
+
+			void add(float x, float y) {
+				if (!(x >= left && x < right && y >= top && y < bottom)) { return; }
+				counts[(size_t)((int)y - top) * width + ((int)x - left)]++;
+			}
+			Render::Image finish();
+
+		private:
+			int left, top, right, bottom;
+			int width;
+			Render::Pixel color;
+			std::vector<uint32_t> counts;
+		};
+
+		// Picks each frame's level. A frame over budget makes the next one coarser; SP_DETAIL_SETTLE frames in a
+		// row within SP_DETAIL_HEADROOM of the budget make it finer again. Frames may finish on any thread:
+		// frame() and setBudget() take turns, and anything may read the stats without waiting.
+		class Governor {
+		public:
+			void setBudget(double milliseconds);// SP_FRAMERATE_BUDGET, or 0 for full detail
+			double getBudget() const { return budget.load(std::memory_order_relaxed); }
+			int getLevel() const { return level.load(std::memory_order_relaxed); }
+			void frame(double milliseconds, double effectiveBudget);// effectiveBudget resolves SP_FRAMERATE_BUDGET
+			DetailStats getStats(double effectiveBudget) const;
+
+		private:
+			std::atomic<double> budget = 0;
+			std::atomic<int> level = 0;
+			std::atomic<double> frameTime = 0;
+			int underBudget = 0;// Frames in a row with headroom
+			std::mutex updateMutex;// Held across each update, so concurrent frames don't lose a step
+		};
+	}
+}
\ No newline at end of file
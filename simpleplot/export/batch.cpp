@@ -0,0 +1,108 @@
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <map>
+#include <memory>
+
+#include "batch.h"
+#include "png.h"
+#include "svg.h"
+#include "../canvas.h"
+#include "../plots/plot.h"
+#include "../render/pool.h"
+
+
+namespace SimplePlot {
+	namespace {
+		class CanvasDeleter {
+		public:
+			CanvasDeleter(CANVAS_ID id) : id(id) {}
+			~CanvasDeleter() { deleteCanvas(id); }
+
+		private:
+			CANVAS_ID id;
+		};
+
+		JobResult runJob(CanvasJob const& job) {
+			JobResult result;
+			auto start = std::chrono::steady_clock::now();
+			try {
+				if (job.width <= 0 || job.height <= 0) {
+					throw std::invalid_argument("Job dimensions must be positive");
+				}
+				std::vector<PLOT_ID> sorted = job.plots;
+				std::sort(sorted.begin(), sorted.end());
+				if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end()) {
+					throw std::invalid_argument("Plot is listed twice in the job");
+				}
+				for (PLOT_ID plot : job.plots) {
+					// Moving it would take it off a canvas that is still being drawn.
+					if (getPlotCanvas(plot) != SP_NULL_CANVAS) {
+						throw std::invalid_argument("Plot is already on a canvas");
+					}
+				}
+				CANVAS_ID canvas = makeOffscreenCanvas(job.plots, job.name, job.style);
+				CanvasDeleter deleter(canvas);
+				setCanvasLegend(canvas, job.legend);
+				setCanvasGridLines(canvas, job.gridLines);
+				if (job.configure) {
+					job.configure(canvas);
+				}
+
+				bool written;
+				if (job.format == EXPORT_FORMAT::SVG) {
+					written = renderCanvasToSVG(canvas, job.path, job.width, job.height);
+				}
+				else {
+					Render::Framebuffer fb(job.width, job.height);
+					renderCanvas(canvas, fb, false);
+					written = Export::writePNG(fb, job.path, SP_DEFLATE_LEVEL, 1);
+				}
+				result.ok = written;
+				if (!written) {
+					result.error = "Could not write the output file";
+				}
+			}
+			catch (std::exception const& e) {
+				result.ok = false;
+				result.error = e.what();
+			}
+			catch (...) {
+				result.ok = false;
+				result.error = "Unknown error";
+			}
+			result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			return result;
+		}
+	}
+
+	std::vector<JobResult> renderBatch(std::vector<CanvasJob> const& jobs, int numThreads) {
+		std::vector<JobResult> results(jobs.size());
+		std::unique_ptr<Render::Pool> ownPool;
+		Render::Pool* pool = &Render::getPool();
+		if (numThreads > 0) {
+			ownPool = std::make_unique<Render::Pool>(numThreads);
+			pool = ownPool.get();
+		}
+		// Jobs run side by side, so a plot shared between two would be taken from one canvas mid-frame. The
+		// first job to list it keeps it.
+		std::map<PLOT_ID, int> owners;
+		std::vector<bool> shared(jobs.size(), false);
+		for (int i = 0; i < (int)jobs.size(); i++) {
+			for (PLOT_ID plot : jobs[i].plots) {
+				int owner = owners.emplace(plot, i).first->second;
+				if (owner != i) {
+					shared[i] = true;
+				}
+			}
+		}
+		pool->parallelFor((int)jobs.size(), [&jobs, &results, &shared](int i) {
+			if (shared[i]) {
+				results[i].error = "Plot is in an earlier job of the batch";
+				return;
+			}
+			results[i] = runJob(jobs[i]);
+		});
+		return results;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "../standard.h"
+
+
+namespace SimplePlot {
+	// One figure of a batch. The plots are put on a canvas of their own for the duration of the job, so they
+	// must not be on a canvas already, and a plot can only be listed once in a batch; jobs that break either
+	// rule fail without touching their plots.
+	struct CanvasJob {
+		std::vector<PLOT_ID> plots;
+		std::wstring path;
+		EXPORT_FORMAT format = EXPORT_FORMAT::PNG;
+		int width = SP_DEFAULT_WIDTH;
+		int height = SP_DEFAULT_HEIGHT;
+		std::wstring name;
+		int style = 0;
+		bool legend = false;
+		bool gridLines = true;
+		std::function<void(CANVAS_ID)> configure;// Optional: any other setCanvas... calls, made before rendering
+	};
+
+	struct JobResult {
+		bool ok = false;
+		std::string error;// Why the job failed; empty when it succeeded
+		double milliseconds = 0;
+	};
+
+	// Renders and writes every job offscreen, spread over a pool of numThreads workers (0: the shared pool, one
+	// thread per core). Each job rasterizes and encodes on a single thread, so jobs scale with cores without
+	// contending for the pool. A job that throws or can't write its file is reported in its result; the
+	// rest of the batch carries on. Results are in the order of the jobs.
+	std::vector<JobResult> renderBatch(std::vector<CanvasJob> const& jobs, int numThreads = 0);
+}
\ No newline at end of file
@@ -0,0 +1,62 @@
+#include "checksum.h"
+
+
+namespace SimplePlot::Export {
+	namespace {
+		struct CrcTable {
+			uint32_t entries[256];
+
+			CrcTable() {
+				for (uint32_t n = 0; n < 256; n++) {
+					uint32_t c = n;
+					for (int k = 0; k < 8; k++) {
+						c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+					}
+					entries[n] = c;
+				}
+			}
+		};
+		const CrcTable crcTable;
+	}
+
+	uint32_t crc32(uint32_t crc, uint8_t const* data, size_t size) {
+		uint32_t c = crc ^ 0xffffffffu;
+		for (size_t i = 0; i < size; i++) {
+			c = crcTable.entries[(c ^ data[i]) & 0xff] ^ (c >> 8);
+		}
+		return c ^ 0xffffffffu;
+	}
+
+	uint32_t adler32(uint32_t adler, uint8_t const* data, size_t size) {
+		// The sums can go 5552 bytes before they need reducing without overflowing 32 bits.
+		uint32_t a = adler & 0xffff;
+		uint32_t b = adler >> 16;
+		while (size > 0) {
+			size_t block = size < 5552 ? size : 5552;
+			size -= block;
+			for (size_t i = 0; i < block; i++) {
+				a += data[i];
+				b += a;
+			}
+			data += block;
+			a %= 65521;
+			b %= 65521;
+		}
+		return (b << 16) | a;
+	}
+
+	uint32_t adler32Combine(uint32_t adler1, uint32_t adler2, size_t size2) {
+		// As zlib's adler32_combine: appending n bytes adds n * a1 to the second sum.
+		const uint32_t BASE = 65521;
+		uint32_t remainder = (uint32_t)(size2 % BASE);
+		uint32_t sum1 = adler1 & 0xffff;
+		uint32_t sum2 = (uint32_t)(((uint64_t)remainder * sum1) % BASE);
+		sum1 += (adler2 & 0xffff) + BASE - 1;
+		sum2 += ((adler1 >> 16) & 0xffff) + ((adler2 >> 16) & 0xffff) + BASE - remainder;
+		if (sum1 >= BASE) { sum1 -= BASE; }
+		if (sum1 >= BASE) { sum1 -= BASE; }
+		if (sum2 >= (BASE << 1)) { sum2 -= (BASE << 1); }
+		if (sum2 >= BASE) { sum2 -= BASE; }
+		return sum1 | (sum2 << 16);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+
+namespace SimplePlot::Export {
+	// Running checksums: start from the initial value and feed the data in as many pieces as convenient.
+	const uint32_t CRC32_INITIAL = 0;
+	const uint32_t ADLER32_INITIAL = 1;
+
+	uint32_t crc32(uint32_t crc, uint8_t const* data, size_t size);// As used by PNG chunks
+	uint32_t adler32(uint32_t adler, uint8_t const* data, size_t size);// As used by zlib streams
+	uint32_t adler32Combine(uint32_t adler1, uint32_t adler2, size_t size2);// Of the data of adler1 followed by size2 bytes with adler2
+}
\ No newline at end of file
@@ -0,0 +1,577 @@
+#include "deflate.h"
+#include "checksum.h"
+#include "../render/pool.h"
+#include "../trace.h"
+#include <algorithm>
+#include <queue>
+#include <stdexcept>
+
+
+namespace SimplePlot::Export {
+	namespace {
+		const int WINDOW_SIZE = 1 << 15;
+		const int MIN_MATCH = 3;
+		const int MAX_MATCH = 258;
+		const int HASH_BITS = 15;
+		const int HASH_MASK = (1 << HASH_BITS) - 1;
+		const int BLOCK_SYMBOLS = 1 << 14;// Symbols per Huffman block, so the codes can follow the data
+		const int MAX_STORED = 65535;
+
+		const int lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+			35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+		const int lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+			3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+		const int distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+			257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+		const int distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+			7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+		const int codeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+		struct LevelParameters {
+			int maxChain;// Candidates tried per match
+			int niceLength;// A match this long is taken without looking further
+			bool lazy;// Check whether the next position starts a longer match before taking one
+		};
+		const LevelParameters levels[10] = {
+			{ 0, 0, false }, { 4, 8, false }, { 8, 16, false }, { 16, 32, false }, { 16, 32, true },
+			{ 32, 64, true }, { 128, 128, true }, { 256, 258, true }, { 1024, 258, true }, { 4096, 258, true },
+		};
+
+		uint32_t reverseBits(uint32_t code, int count) {
+			uint32_t result = 0;
+			for (int i = 0; i < count; i++) {
+				result = (result << 1) | (code & 1);
+				code >>= 1;
+			}
+			return result;
+		}
+
+		// Canonical Huffman codes for a set of code lengths (RFC 1951 3.2.2), bit reversed since deflate packs
+		// bits from the least significant end.
+		void buildCodes(uint8_t const* lengths, int n, uint16_t* codes) {
+			int count[16] = { 0 };
+			for (int i = 0; i < n; i++) {
+				count[lengths[i]]++;
+			}
+			count[0] = 0;
+			int next[16] = { 0 };
+			int code = 0;
+			for (int bits = 1; bits < 16; bits++) {
+				code = (code + count[bits - 1]) << 1;
+				next[bits] = code;
+			}
+			for (int i = 0; i < n; i++) {
+				codes[i] = lengths[i] ? (uint16_t)reverseBits(next[lengths[i]]++, lengths[i]) : 0;
+			}
+		}
+
+		// Huffman code lengths of at most maxBits for the given frequencies. Too deep a tree is fixed by halving
+		// the frequencies and trying again, which costs a little optimality on rare, very skewed blocks. At least
+		// two symbols get codes, so every code is complete.
+		void buildLengths(uint32_t const* frequencies, int n, int maxBits, uint8_t* lengths) {
+			std::vector<uint32_t> weights(frequencies, frequencies + n);
+			int used = 0;
+			for (int i = 0; i < n && used < 2; i++) {
+				used += weights[i] > 0;
+			}
+			for (int i = 0; i < n && used < 2; i++) {
+				if (weights[i] == 0) {
+					weights[i] = 1;
+					used++;
+				}
+			}
+
+			std::vector<int> parent;
+			std::vector<std::pair<uint32_t, int>> nodes;
+			while (true) {
+				// Leaves are the used symbols; internal nodes follow. Ties go to the lower index, so the result
+				// doesn't depend on the queue's implementation.
+				std::priority_queue<std::pair<uint32_t, int>, std::vector<std::pair<uint32_t, int>>, std::greater<>> queue;
+				std::vector<int> symbol;
+				for (int i = 0; i < n; i++) {
+					if (weights[i] > 0) {
+						queue.push({ weights[i], (int)symbol.size() });
+						symbol.push_back(i);
+					}
+				}
+				int leaves = (int)symbol.size();
+				parent.assign(2 * leaves - 1, -1);
+				int next = leaves;
+				while (queue.size() > 1) {
+					std::pair<uint32_t, int> a = queue.top();
+					queue.pop();
+					std::pair<uint32_t, int> b = queue.top();
+					queue.pop();
+					parent[a.second] = next;
+					parent[b.second] = next;
+					queue.push({ a.first + b.first, next });
+					next++;
+				}
+
+				// Parents always come after their children, so depths fill in from the root down.
+				std::vector<int> depth(2 * leaves - 1, 0);
+				int deepest = 0;
+				for (int node = 2 * leaves - 3; node >= 0; node--) {
+					depth[node] = depth[parent[node]] + 1;
+					deepest = (std::max)(deepest, depth[node]);
+				}
+				if (deepest <= maxBits) {
+					std::fill(lengths, lengths + n, (uint8_t)0);
+					for (int leaf = 0; leaf < leaves; leaf++) {
+						lengths[symbol[leaf]] = (uint8_t)depth[leaf];
+					}
+					return;
+				}
+				for (uint32_t& w : weights) {
+					if (w > 0) {
+						w = (w >> 1) | 1;
+					}
+				}
+			}
+		}
+
+		struct FixedTables {
+			uint8_t literalLengths[288];
+			uint16_t literalCodes[288];
+			uint8_t distanceLengths[30];
+			uint16_t distanceCodes[30];
+			uint8_t lengthSymbol[MAX_MATCH + 1];
+			uint8_t distanceSymbol[512];// Distances up to 256 directly, then by (distance - 1) >> 7
+
+			FixedTables() {
+				for (int v = 0; v < 288; v++) {
+					literalLengths[v] = v < 144 ? 8 : (v < 256 ? 9 : (v < 280 ? 7 : 8));
+				}
+				buildCodes(literalLengths, 288, literalCodes);
+				std::fill(distanceLengths, distanceLengths + 30, (uint8_t)5);
+				buildCodes(distanceLengths, 30, distanceCodes);
+
+				for (int s = 0; s < 28; s++) {
+					for (int length = lengthBase[s]; length < lengthBase[s + 1]; length++) {
+						lengthSymbol[length] = (uint8_t)s;
+					}
+				}
+				lengthSymbol[MAX_MATCH] = 28;// 258 has its own code rather than being 227 + 31
+				for (int s = 0; s < 30; s++) {
+					int last = s == 29 ? WINDOW_SIZE : distanceBase[s + 1] - 1;
+					for (int distance = distanceBase[s]; distance <= last; distance++) {
+						if (distance <= 256) {
+							distanceSymbol[distance - 1] = (uint8_t)s;
+						}
+						else {
+							distanceSymbol[256 + ((distance - 1) >> 7)] = (uint8_t)s;
+						}
+					}
+				}
+			}
+
+			int getDistanceSymbol(int distance) const {
+				return distance <= 256 ? distanceSymbol[distance - 1] : distanceSymbol[256 + ((distance - 1) >> 7)];
+			}
+		};
+		const FixedTables tables;
+
+		class BitWriter {
+		public:
+			BitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+			void put(uint32_t bits, int count) {
+				buffer |= (uint64_t)bits << this->count;
+				this->count += count;
+				while (this->count >= 8) {
+					out.push_back((uint8_t)buffer);
+					buffer >>= 8;
+					this->count -= 8;
+				}
+			}
+
+			void align() {
+				if (count > 0) {
+					put(0, 8 - count);
+				}
+			}
+
+			void putBytes(uint8_t const* data, size_t size) {// Only once aligned
+				out.insert(out.end(), data, data + size);
+			}
+
+		private:
+			std::vector<uint8_t>& out;
+			uint64_t buffer = 0;
+			int count = 0;
+		};
+
+		struct Symbol {
+			uint16_t value;// A literal byte, or a match length
+			uint16_t distance;// 0 for a literal
+		};
+
+		// Compresses one chunk into a run of complete deflate blocks. Each worker thread keeps its own, so the
+		// match tables are allocated once per thread rather than once per chunk.
+		class ChunkCompressor {
+		public:
+			void compress(uint8_t const* window, int dictionarySize, int size, int level, bool last, std::vector<uint8_t>& out) {
+				BitWriter bits(out);
+				this->window = window;
+				end = dictionarySize + size;
+				if (level <= 0) {
+					putStored(bits, dictionarySize, end, last);
+					return;// Stored blocks end on a byte boundary, so no flush is needed between chunks
+				}
+				LevelParameters const& params = levels[(std::min)(level, 9)];
+
+				head.assign(HASH_MASK + 1, -1);
+				if ((int)prev.size() < end) {
+					prev.resize(end);
+				}
+				inserted = 0;
+				insertUpTo(dictionarySize - 1);
+
+				symbols.clear();
+				blockStart = dictionarySize;
+				int position = dictionarySize;
+				while (position < end) {
+					int length = 0;
+					int distance = 0;
+					if (end - position >= MIN_MATCH) {
+						insertUpTo(position - 1);
+						length = longestMatch(position, params, distance);
+						if (params.lazy && length >= MIN_MATCH && length < params.niceLength && end - position - 1 >= MIN_MATCH) {
+							insertUpTo(position);
+							int nextDistance;
+							if (longestMatch(position + 1, params, nextDistance) > length) {
+								length = 0;
+							}
+						}
+					}
+					if (length >= MIN_MATCH) {
+						symbols.push_back({ (uint16_t)length, (uint16_t)distance });
+						position += length;
+						if (!params.lazy && length > params.niceLength) {
+							// The fast levels don't index the inside of long matches, mostly runs of background.
+							inserted = (std::max)(inserted, position - 1);
+						}
+					}
+					else {
+						symbols.push_back({ window[position], 0 });
+						position++;
+					}
+					if ((int)symbols.size() >= BLOCK_SYMBOLS) {
+						putBlock(bits, position, false);
+					}
+				}
+				if (!symbols.empty() || last) {
+					putBlock(bits, position, last);
+				}
+				if (last) {
+					bits.align();
+				}
+				else {
+					// Sync flush: an empty stored block brings the chunk to a byte boundary, so the next chunk's
+					// blocks can simply be appended.
+					bits.put(0, 3);
+					bits.align();
+					out.push_back(0);
+					out.push_back(0);
+					out.push_back(0xff);
+					out.push_back(0xff);
+				}
+			}
+
+		private:
+			int hashAt(int p) const {
+				return ((window[p] << 10) ^ (window[p + 1] << 5) ^ window[p + 2]) & HASH_MASK;
+			}
+
+			void insertUpTo(int p) {
+				for (; inserted <= p && inserted + MIN_MATCH <= end; inserted++) {
+					int hash = hashAt(inserted);
+					prev[inserted] = head[hash];
+					head[hash] = inserted;
+				}
+			}
+
+			int longestMatch(int p, LevelParameters const& params, int& distance) const {
+				uint8_t const* w = window + p;
+				int limit = (std::max)(p - WINDOW_SIZE, 0);
+				int maxLength = (std::min)(MAX_MATCH, end - p);
+				int best = 0;
+				int candidate = head[hashAt(p)];
+				for (int chain = 0; chain < params.maxChain && candidate >= limit; chain++) {
+					uint8_t const* c = window + candidate;
+					// Only a match that beats the best so far is worth scanning, and it must agree at that length.
+					if (c[best] == w[best] && c[0] == w[0] && c[1] == w[1]) {
+						int length = 2;
+						while (length < maxLength && c[length] == w[length]) {
+							length++;
+						}
+						if (length > best) {
+							best = length;
+							distance = p - candidate;
+							if (length >= params.niceLength || length == maxLength) {
+								break;
+							}
+						}
+					}
+					candidate = prev[candidate];
+				}
+				return best;
+			}
+
+			void putStored(BitWriter& bits, int begin, int stop, bool last) {
+				do {
+					int size = (std::min)(stop - begin, MAX_STORED);
+					bool final = last && begin + size == stop;
+					bits.put(final ? 1 : 0, 3);
+					bits.align();
+					bits.put(size, 16);
+					bits.put(~size & 0xffff, 16);
+					bits.putBytes(window + begin, size);
+					begin += size;
+				} while (begin < stop);
+			}
+
+			void putBlock(BitWriter& bits, int position, bool final) {
+				// Picks whichever of dynamic codes, the fixed codes or a stored copy is smallest for the block.
+				uint32_t literalFrequencies[286] = { 0 };
+				uint32_t distanceFrequencies[30] = { 0 };
+				long long extraBits = 0;
+				for (Symbol const& s : symbols) {
+					if (s.distance == 0) {
+						literalFrequencies[s.value]++;
+					}
+					else {
+						int l = tables.lengthSymbol[s.value];
+						int d = tables.getDistanceSymbol(s.distance);
+						literalFrequencies[257 + l]++;
+						distanceFrequencies[d]++;
+						extraBits += lengthExtra[l] + distanceExtra[d];
+					}
+				}
+				literalFrequencies[256] = 1;
+
+				uint8_t literalLengths[286];
+				uint8_t distanceLengths[30];
+				buildLengths(literalFrequencies, 286, 15, literalLengths);
+				buildLengths(distanceFrequencies, 30, 15, distanceLengths);
+
+				int numLiterals = 286;
+				while (numLiterals > 257 && literalLengths[numLiterals - 1] == 0) {
+					numLiterals--;
+				}
+				int numDistances = 30;
+				while (numDistances > 1 && distanceLengths[numDistances - 1] == 0) {
+					numDistances--;
+				}
+
+				// Run length code the two sets of lengths together.
+				uint8_t all[286 + 30];
+				std::copy(literalLengths, literalLengths + numLiterals, all);
+				std::copy(distanceLengths, distanceLengths + numDistances, all + numLiterals);
+				int total = numLiterals + numDistances;
+				lengthSymbols.clear();
+				for (int i = 0; i < total;) {
+					int value = all[i];
+					int run = 1;
+					while (i + run < total && all[i + run] == value) {
+						run++;
+					}
+					i += run;
+					if (value == 0) {
+						while (run >= 11) {
+							int r = (std::min)(run, 138);
+							lengthSymbols.push_back({ 18, (uint16_t)(r - 11) });
+							run -= r;
+						}
+						if (run >= 3) {
+							lengthSymbols.push_back({ 17, (uint16_t)(run - 3) });
+							run = 0;
+						}
+					}
+					else {
+						lengthSymbols.push_back({ (uint16_t)value, 0 });
+						run--;
+						while (run >= 3) {
+							int r = (std::min)(run, 6);
+							lengthSymbols.push_back({ 16, (uint16_t)(r - 3) });
+							run -= r;
+						}
+					}
+					for (; run > 0; run--) {
+						lengthSymbols.push_back({ (uint16_t)value, 0 });
+					}
+				}
+				uint32_t lengthFrequencies[19] = { 0 };
+				for (Symbol const& s : lengthSymbols) {
+					lengthFrequencies[s.value]++;
+				}
+				uint8_t lengthLengths[19];
+				buildLengths(lengthFrequencies, 19, 7, lengthLengths);
+				int numLengthCodes = 19;
+				while (numLengthCodes > 4 && lengthLengths[codeLengthOrder[numLengthCodes - 1]] == 0) {
+					numLengthCodes--;
+				}
+
+				long long dynamicBits = 14 + 3 * numLengthCodes + extraBits;
+				long long fixedBits = extraBits;
+				for (int i = 0; i < 286; i++) {
+					dynamicBits += (long long)literalFrequencies[i] * literalLengths[i];
+					fixedBits += (long long)literalFrequencies[i] * tables.literalLengths[i];
+				}
+				for (int i = 0; i < 30; i++) {
+					dynamicBits += (long long)distanceFrequencies[i] * distanceLengths[i];
+					fixedBits += (long long)distanceFrequencies[i] * 5;
+				}
+				for (int i = 0; i < 19; i++) {
+					dynamicBits += (long long)lengthFrequencies[i] * lengthLengths[i];
+				}
+				dynamicBits += 2 * lengthFrequencies[16] + 3 * lengthFrequencies[17] + 7 * lengthFrequencies[18];
+				int rawSize = position - blockStart;
+				long long storedBits = 8ll * rawSize + 40ll * (rawSize / MAX_STORED + 1) + 7;
+
+				if (storedBits < (std::min)(dynamicBits, fixedBits)) {
+					putStored(bits, blockStart, position, final);
+				}
+				else if (dynamicBits < fixedBits) {
+					uint16_t lengthCodes[19];
+					buildCodes(lengthLengths, 19, lengthCodes);
+					uint16_t literalCodes[286];
+					buildCodes(literalLengths, 286, literalCodes);
+					uint16_t distanceCodes[30];
+					buildCodes(distanceLengths, 30, distanceCodes);
+
+					bits.put(final ? 1 : 0, 1);
+					bits.put(2, 2);
+					bits.put(numLiterals - 257, 5);
+					bits.put(numDistances - 1, 5);
+					bits.put(numLengthCodes - 4, 4);
+					for (int i = 0; i < numLengthCodes; i++) {
+						bits.put(lengthLengths[codeLengthOrder[i]], 3);
+					}
+					for (Symbol const& s : lengthSymbols) {
+						bits.put(lengthCodes[s.value], lengthLengths[s.value]);
+						if (s.value == 16) { bits.put(s.distance, 2); }
+						else if (s.value == 17) { bits.put(s.distance, 3); }
+						else if (s.value == 18) { bits.put(s.distance, 7); }
+					}
+					putSymbols(bits, literalLengths, literalCodes, distanceLengths, distanceCodes);
+				}
+				else {
+					bits.put(final ? 1 : 0, 1);
+					bits.put(1, 2);
+					putSymbols(bits, tables.literalLengths, tables.literalCodes, tables.distanceLengths, tables.distanceCodes);
+				}
+				symbols.clear();
+				blockStart = position;
+			}
+
+			void putSymbols(BitWriter& bits, uint8_t const* literalLengths, uint16_t const* literalCodes,
+				uint8_t const* distanceLengths, uint16_t const* distanceCodes) {
+				for (Symbol const& s : symbols) {
+					if (s.distance == 0) {
+						bits.put(literalCodes[s.value], literalLengths[s.value]);
+						continue;
+					}
+					int l = tables.lengthSymbol[s.value];
+					bits.put(literalCodes[257 + l], literalLengths[257 + l]);
+					bits.put(s.value - lengthBase[l], lengthExtra[l]);
+					int d = tables.getDistanceSymbol(s.distance);
+					bits.put(distanceCodes[d], distanceLengths[d]);
+					bits.put(s.distance - distanceBase[d], distanceExtra[d]);
+				}
+				bits.put(literalCodes[256], literalLengths[256]);
+			}
+
+			uint8_t const* window = nullptr;// The dictionary, then the chunk
+			int end = 0;
+			int inserted = 0;// Positions below this are in the hash chains
+			int blockStart = 0;
+			std::vector<int> head;// Most recent position for each hash, or -1
+			std::vector<int> prev;// Previous position with the same hash
+			std::vector<Symbol> symbols;
+			std::vector<Symbol> lengthSymbols;// Code length symbols, with their repeat counts in distance
+		};
+
+		ChunkCompressor& getChunkCompressor() {
+			thread_local ChunkCompressor compressor;
+			return compressor;
+		}
+	}
+
+	Deflater::Deflater(Sink sink, int level, int numThreads) : sink(sink), level((std::max)((std::min)(level, 9), 0)),
+		numThreads(numThreads > 0 ? numThreads : Render::getPool().size() + 1), adler(ADLER32_INITIAL) {
+		// The header's level field is only a hint to recompressors.
+		uint8_t header[2] = { 0x78, 0x01 };
+		header[1] = this->level < 2 ? 0x01 : (this->level < 6 ? 0x5e : (this->level == 6 ? 0x9c : 0xda));
+		this->sink(header, sizeof(header));
+		input.reserve(WINDOW_SIZE + (size_t)this->numThreads * SP_DEFLATE_CHUNK);
+	}
+
+	void Deflater::write(uint8_t const* data, size_t size) {
+		if (finished) {
+			throw std::logic_error("Deflater was already finished");
+		}
+		size_t capacity = dictionarySize + (size_t)numThreads * SP_DEFLATE_CHUNK;
+		while (size > 0) {
+			size_t count = (std::min)(size, capacity - input.size());
+			input.insert(input.end(), data, data + count);
+			data += count;
+			size -= count;
+			if (input.size() == capacity) {
+				compressPending(false);
+				capacity = dictionarySize + (size_t)numThreads * SP_DEFLATE_CHUNK;
+			}
+		}
+	}
+
+	void Deflater::finish() {
+		if (finished) {
+			return;
+		}
+		compressPending(true);
+		uint8_t trailer[4] = { (uint8_t)(adler >> 24), (uint8_t)(adler >> 16), (uint8_t)(adler >> 8), (uint8_t)adler };
+		sink(trailer, sizeof(trailer));
+		finished = true;
+	}
+
+	void Deflater::compressPending(bool last) {
+		size_t pending = input.size() - dictionarySize;
+		int count = (int)(pending / SP_DEFLATE_CHUNK);
+		if (last && (count == 0 || pending % SP_DEFLATE_CHUNK != 0)) {
+			count++;
+		}
+		chunkOutput.resize((std::max)((int)chunkOutput.size(), count));
+		chunkAdler.resize(chunkOutput.size());
+
+		auto compressChunk = [this, count, last](int k) {
+			Trace::Span span("deflate chunk", "export", k);
+			size_t start = dictionarySize + (size_t)k * SP_DEFLATE_CHUNK;
+			int size = (int)(std::min)((size_t)SP_DEFLATE_CHUNK, input.size() - start);
+			int dictionary = (int)(std::min)((size_t)WINDOW_SIZE, start);
+			chunkOutput[k].clear();
+			getChunkCompressor().compress(input.data() + start - dictionary, dictionary, size, level, last && k == count - 1, chunkOutput[k]);
+			chunkAdler[k] = adler32(ADLER32_INITIAL, input.data() + start, size);
+		};
+		if (numThreads > 1 && count > 1) {
+			Render::getPool().parallelFor(count, compressChunk);
+		}
+		else {
+			for (int k = 0; k < count; k++) {
+				compressChunk(k);
+			}
+		}
+
+		size_t consumed = dictionarySize;
+		for (int k = 0; k < count; k++) {
+			size_t size = (std::min)((size_t)SP_DEFLATE_CHUNK, input.size() - consumed);
+			sink(chunkOutput[k].data(), chunkOutput[k].size());
+			adler = adler32Combine(adler, chunkAdler[k], size);
+			consumed += size;
+		}
+
+		// Keep the last window of what was compressed as the next chunk's dictionary.
+		size_t keep = (std::min)((size_t)WINDOW_SIZE, consumed);
+		input.erase(input.begin(), input.begin() + (consumed - keep));
+		dictionarySize = keep;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "../standard.h"
+
+
+namespace SimplePlot::Export {
+	// Receives encoded output as it is produced. The pointer is only valid for the duration of the call.
+	typedef std::function<void(uint8_t const*, size_t)> Sink;
+
+	// A streaming zlib (RFC 1950/1951) compressor. Input can be written in pieces of any size. It is cut into
+	// chunks of SP_DEFLATE_CHUNK bytes that are compressed independently, each primed with the 32KB before it
+	// so matches still reach back across the cut, and the chunks' deflate blocks are joined with empty stored
+	// blocks into one stream, as pigz does. With numThreads > 1 that many chunks are compressed at once on
+	// the render pool; the output is the same whatever the thread count. Only the chunks in flight are held,
+	// and compressed bytes go to the sink as each batch of chunks completes.
+	//
+	// level runs from 0 (stored, no compression) to 9 (slowest, smallest), as in zlib. numThreads 0 means one
+	// per core.
+	class Deflater {
+	public:
+		Deflater(Sink sink, int level = SP_DEFLATE_LEVEL, int numThreads = 1);
+		Deflater(Deflater const&) = delete;
+		Deflater& operator=(Deflater const&) = delete;
+
+		void write(uint8_t const* data, size_t size);
+		void finish();// Ends the stream; nothing may be written afterwards
+
+	private:
+		void compressPending(bool last);
+
+		Sink sink;
+		int level;
+		int numThreads;
+		uint32_t adler;
+
+		std::vector<uint8_t> input;// The dictionary for the first pending chunk, then the pending chunks
+		size_t dictionarySize = 0;
+		std::vector<std::vector<uint8_t>> chunkOutput;
+		std::vector<uint32_t> chunkAdler;
+		bool finished = false;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,251 @@
+#include <filesystem>
+#include <fstream>
+#include <cstdlib>
+#include <stdexcept>
+
+#include "png.h"
+#include "checksum.h"
+#include "../canvas.h"
+#include "../trace.h"
+
+
+namespace SimplePlot {
+	namespace Export {
+		namespace {
+			int paeth(int a, int b, int c) {
+				int p = a + b - c;
+				int pa = std::abs(p - a);
+				int pb = std::abs(p - b);
+				int pc = std::abs(p - c);
+				return (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+			}
+
+			void putUint32(uint8_t* p, uint32_t value) {
+				p[0] = (uint8_t)(value >> 24);
+				p[1] = (uint8_t)(value >> 16);
+				p[2] = (uint8_t)(value >> 8);
+				p[3] = (uint8_t)value;
+			}
+		}
+
+		PngWriter::PngWriter(Sink sink, int width, int height, bool alpha, int level, int numThreads) : sink(sink), width(width),
+			height(height), alpha(alpha), level(level), numThreads(numThreads), currentRow((alpha ? 4 : 3) * (size_t)width),
+			previousRow(currentRow.size()), rowBuffer(1 + currentRow.size()), imageData(4) {
+			if (width <= 0 || height <= 0) {
+				throw std::invalid_argument("PNG dimensions must be positive");
+			}
+			imageData.reserve(SP_PNG_IDAT_SIZE + (1 << 14));
+
+			static const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+			this->sink(signature, sizeof(signature));
+			uint8_t header[13];
+			putUint32(header, width);
+			putUint32(header + 4, height);
+			header[8] = 8;// Bit depth
+			header[9] = alpha ? 6 : 2;// Colour type: RGBA or RGB
+			header[10] = 0;// Deflate
+			header[11] = 0;// Adaptive filtering
+			header[12] = 0;// Not interlaced
+			writeChunk("IHDR", header, sizeof(header));
+		}
+
+		void PngWriter::beginAnimation(int numFrames, int numPlays) {
+			if (animated || frames > 0) {
+				throw std::logic_error("beginAnimation must come before any image data");
+			}
+			uint8_t chunk[PNG_ANIMATION_CONTROL_SIZE];
+			makeAnimationControl(numFrames, numPlays, chunk);
+			sink(chunk, sizeof(chunk));
+			animated = true;
+		}
+
+		void PngWriter::beginFrame(int delayNumerator, int delayDenominator) {
+			if (!animated) {
+				throw std::logic_error("beginFrame needs beginAnimation");
+			}
+			if (frames > 0) {
+				endFrame();
+			}
+			uint8_t control[26];
+			putUint32(control, sequence++);
+			putUint32(control + 4, width);
+			putUint32(control + 8, height);
+			putUint32(control + 12, 0);// Offset
+			putUint32(control + 16, 0);
+			control[20] = (uint8_t)(delayNumerator >> 8);
+			control[21] = (uint8_t)delayNumerator;
+			control[22] = (uint8_t)(delayDenominator >> 8);
+			control[23] = (uint8_t)delayDenominator;
+			control[24] = 0;// Dispose: none
+			control[25] = 0;// Blend: source, since every frame covers the whole image
+			writeChunk("fcTL", control, sizeof(control));
+			frames++;
+			rowsWritten = 0;
+			deflater.reset();
+		}
+
+		void PngWriter::writeRow(Render::Pixel const* row) {
+			if (animated && frames == 0) {
+				throw std::logic_error("beginFrame must come before an animation's rows");
+			}
+			if (rowsWritten >= height) {
+				throw std::logic_error("More rows than the PNG height");
+			}
+			if (!deflater) {
+				deflater = std::make_unique<Deflater>([this](uint8_t const* data, size_t size) {
+					imageData.insert(imageData.end(), data, data + size);
+					if (imageData.size() >= SP_PNG_IDAT_SIZE) {
+						writeImageData();
+					}
+				}, level, numThreads);
+				std::fill(previousRow.begin(), previousRow.end(), (uint8_t)0);
+			}
+			uint8_t* out = currentRow.data();
+			for (int x = 0; x < width; x++) {
+				Render::Pixel p = row[x];
+				*out++ = (uint8_t)(p >> 16);
+				*out++ = (uint8_t)(p >> 8);
+				*out++ = (uint8_t)p;
+				if (alpha) {
+					*out++ = (uint8_t)(p >> 24);
+				}
+			}
+			filterRow();
+			deflater->write(rowBuffer.data(), rowBuffer.size());
+			std::swap(currentRow, previousRow);
+			rowsWritten++;
+		}
+
+		void PngWriter::filterRow() {
+			// Picks the filter per row with the usual heuristic: the smallest sum of the filtered bytes read as
+			// signed, which favours rows of small differences. Without compression there is nothing to gain.
+			int bpp = alpha ? 4 : 3;
+			int n = (int)currentRow.size();
+			uint8_t const* cur = currentRow.data();
+			uint8_t const* prev = previousRow.data();
+			int type = 0;
+			if (level > 0) {
+				unsigned long long sums[5] = { 0 };
+				for (int i = 0; i < n; i++) {
+					int a = i >= bpp ? cur[i - bpp] : 0;
+					int b = prev[i];
+					int c = i >= bpp ? prev[i - bpp] : 0;
+					uint8_t candidates[5] = { cur[i], (uint8_t)(cur[i] - a), (uint8_t)(cur[i] - b), (uint8_t)(cur[i] - ((a + b) >> 1)),
+						(uint8_t)(cur[i] - paeth(a, b, c)) };
+					for (int f = 0; f < 5; f++) {
+						sums[f] += candidates[f] < 128 ? candidates[f] : 256 - candidates[f];
+					}
+				}
+				for (int f = 1; f < 5; f++) {
+					if (sums[f] < sums[type]) {
+						type = f;
+					}
+				}
+			}
+
+			uint8_t* out = rowBuffer.data();
+			*out++ = (uint8_t)type;
+			for (int i = 0; i < n; i++) {
+				int a = i >= bpp ? cur[i - bpp] : 0;
+				int b = prev[i];
+				int c = i >= bpp ? prev[i - bpp] : 0;
+				int predictor = 0;
+				switch (type) {
+				case 1: predictor = a; break;
+				case 2: predictor = b; break;
+				case 3: predictor = (a + b) >> 1; break;
+				case 4: predictor = paeth(a, b, c); break;
+				}
+				out[i] = (uint8_t)(cur[i] - predictor);
+			}
+		}
+
+		void PngWriter::finish() {
+			endFrame();
+			writeChunk("IEND", nullptr, 0);
+		}
+
+		void PngWriter::endFrame() {
+			if (rowsWritten != height) {
+				throw std::logic_error("Fewer rows than the PNG height");
+			}
+			deflater->finish();
+			if (imageData.size() > 4) {
+				writeImageData();
+			}
+		}
+
+		void PngWriter::writeChunk(char const* type, uint8_t const* data, size_t size) {
+			uint8_t prefix[8];
+			putUint32(prefix, (uint32_t)size);
+			std::copy(type, type + 4, prefix + 4);
+			uint32_t crc = crc32(CRC32_INITIAL, prefix + 4, 4);
+			crc = crc32(crc, data, size);
+			uint8_t suffix[4];
+			putUint32(suffix, crc);
+
+			sink(prefix, sizeof(prefix));
+			if (size > 0) {
+				sink(data, size);
+			}
+			sink(suffix, sizeof(suffix));
+		}
+
+		void PngWriter::writeImageData() {
+			// The first frame of an animation is also the still image, so it goes in IDAT like any other PNG.
+			if (frames <= 1) {
+				writeChunk("IDAT", imageData.data() + 4, imageData.size() - 4);
+			}
+			else {
+				putUint32(imageData.data(), sequence++);
+				writeChunk("fdAT", imageData.data(), imageData.size());
+			}
+			imageData.resize(4);
+		}
+
+		void makeAnimationControl(int numFrames, int numPlays, uint8_t* chunk) {
+			putUint32(chunk, 8);
+			std::copy("acTL", "acTL" + 4, chunk + 4);
+			putUint32(chunk + 8, numFrames);
+			putUint32(chunk + 12, numPlays);
+			putUint32(chunk + 16, crc32(CRC32_INITIAL, chunk + 4, 12));
+		}
+
+		void writePNG(Render::Framebuffer const& fb, Sink sink, int level, int numThreads) {
+			Trace::Span span("png", "export");
+			PngWriter writer(sink, fb.width, fb.height, false, level, numThreads);
+			for (int y = 0; y < fb.height; y++) {
+				writer.writeRow(fb.row(y));
+			}
+			writer.finish();
+		}
+
+		bool writePNG(Render::Framebuffer const& fb, std::wstring const& path, int level, int numThreads) {
+			std::ofstream file(std::filesystem::path(path), std::ios::binary);
+			if (!file) {
+				return false;
+			}
+			writePNG(fb, [&file](uint8_t const* data, size_t size) {
+				file.write((char const*)data, size);
+			}, level, numThreads);
+			file.close();
+			return !file.fail();
+		}
+	}
+
+	bool renderCanvasToPNG(CANVAS_ID id, std::wstring const& path, int width, int height, int level, int numThreads) {
+		Render::Framebuffer fb(width, height);
+		renderCanvas(id, fb);
+		return Export::writePNG(fb, path, level, numThreads);
+	}
+
+	std::vector<uint8_t> renderCanvasToPNGBytes(CANVAS_ID id, int width, int height, int level, int numThreads) {
+		Render::Framebuffer fb(width, height);
+		renderCanvas(id, fb);
+		std::vector<uint8_t> bytes;
+		Export::writePNG(fb, [&bytes](uint8_t const* data, size_t size) {
+			bytes.insert(bytes.end(), data, data + size);
+		}, level, numThreads);
+		return bytes;
+	}
+}
\ No newline at end of file
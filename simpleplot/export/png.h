@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../standard.h"
+#include "../render/framebuffer.h"
+#include "deflate.h"
+
+
+namespace SimplePlot {
+	namespace Export {
+		// Encodes an 8 bit RGB or RGBA PNG one row at a time. Each row gets whichever scanline filter suits it
+		// best, then goes straight into the compressor, and compressed data leaves in IDAT chunks of
+		// SP_PNG_IDAT_SIZE, so the encoder holds a few rows and the deflate chunks in flight rather than a
+		// second copy of the image. level and numThreads are passed on to the Deflater.
+		//
+		// An animated PNG is written by calling beginAnimation once, then beginFrame before each frame's rows.
+		class PngWriter {
+		public:
+			PngWriter(Sink sink, int width, int height, bool alpha = false, int level = SP_DEFLATE_LEVEL, int numThreads = 1);// alpha: keep the pixels' straight alpha
+			PngWriter(PngWriter const&) = delete;
+			PngWriter& operator=(PngWriter const&) = delete;
+
+			void beginAnimation(int numFrames, int numPlays = 0);// numPlays 0 loops forever
+			void beginFrame(int delayNumerator, int delayDenominator);// Delay in seconds, as a fraction
+			void writeRow(Render::Pixel const* row);// Rows top to bottom, exactly height of them per frame
+			void finish();
+
+		private:
+			void endFrame();
+			void filterRow();
+			void writeChunk(char const* type, uint8_t const* data, size_t size);
+			void writeImageData();
+
+			Sink sink;
+			int width;
+			int height;
+			bool alpha;
+			int level;
+			int numThreads;
+			bool animated = false;
+			int frames = 0;// Frames begun
+			uint32_t sequence = 0;// Shared by fcTL and fdAT chunks
+			int rowsWritten = 0;
+			std::vector<uint8_t> currentRow;// RGB(A)
+			std::vector<uint8_t> previousRow;// What the filters predict from; zero above the first row
+			std::vector<uint8_t> rowBuffer;// Filter type then the filtered row
+			std::vector<uint8_t> imageData;// Four bytes of room for an fdAT sequence number, then compressed data
+			std::unique_ptr<Deflater> deflater;// One stream per frame
+		};
+
+		// An animation's acTL chunk and where it sits in the file, so that a writer that doesn't know the frame
+		// count up front can write a placeholder and patch it afterwards.
+		const size_t PNG_ANIMATION_CONTROL_OFFSET = 33;
+		const size_t PNG_ANIMATION_CONTROL_SIZE = 20;
+		void makeAnimationControl(int numFrames, int numPlays, uint8_t* chunk);
+
+		void writePNG(Render::Framebuffer const& fb, Sink sink, int level = SP_DEFLATE_LEVEL, int numThreads = 0);
+		bool writePNG(Render::Framebuffer const& fb, std::wstring const& path, int level = SP_DEFLATE_LEVEL, int numThreads = 0);// false if the file can't be written
+	}
+
+	// Render a canvas offscreen, without touching its window if it has one, and encode the frame as PNG. level is
+	// zlib's, 0 to 9; numThreads is how many chunks are compressed at once, 0 for one per core.
+	bool renderCanvasToPNG(CANVAS_ID id, std::wstring const& path, int width, int height, int level = SP_DEFLATE_LEVEL,
+		int numThreads = 0);// false if the file can't be written
+	std::vector<uint8_t> renderCanvasToPNGBytes(CANVAS_ID id, int width, int height, int level = SP_DEFLATE_LEVEL, int numThreads = 0);
+}
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <filesystem>
+#include <string>
+
+#include "recorder.h"
+#include "../trace.h"
+
+
+namespace SimplePlot::Export {
+	Recorder::Recorder(std::wstring const& path, RECORDING_FORMAT format, int framerate, int queueSize) : format(format),
+		framerate((std::max)(framerate, 1)), queueSize((std::max)(queueSize, 1)),
+		file(std::filesystem::path(path), std::ios::binary | std::ios::trunc) {
+		if (!file) {
+			failed = true;
+			stats.failed = true;
+		}
+		thread = std::thread(&Recorder::encoderLoop, this);
+	}
+
+	Recorder::~Recorder() {
+		stop();
+	}
+
+	void Recorder::stop() {
+		{
+			std::lock_guard<std::mutex> guard(mutex);
+			stopping = true;
+		}
+		wake.notify_one();
+		if (thread.joinable()) {
+			thread.join();
+		}
+	}
+
+	Render::Framebuffer* Recorder::acquire(int width_, int height_) {
+		std::lock_guard<std::mutex> guard(mutex);
+		if (stopping || stats.failed || width_ <= 0 || height_ <= 0) {
+			stats.framesDropped++;
+			return nullptr;
+		}
+		Render::Framebuffer* frame;
+		if (!freeBuffers.empty()) {
+			frame = freeBuffers.back();
+			freeBuffers.pop_back();
+		}
+		else if ((int)buffers.size() < queueSize) {
+			buffers.push_back(std::make_unique<Render::Framebuffer>(width_, height_));
+			frame = buffers.back().get();
+		}
+		else {
+			stats.framesDropped++;
+			return nullptr;
+		}
+		if (frame->width != width_ || frame->height != height_) {
+			*frame = Render::Framebuffer(width_, height_);
+		}
+		return frame;
+	}
+
+	void Recorder::submit(Render::Framebuffer* frame) {
+		{
+			std::lock_guard<std::mutex> guard(mutex);
+			queue.push_back(frame);
+		}
+		wake.notify_one();
+	}
+
+	void Recorder::submitCopy(Render::Framebuffer const& frame) {
+		Render::Framebuffer* copy = acquire(frame.width, frame.height);
+		if (copy) {
+			std::copy(frame.pixels.begin(), frame.pixels.end(), copy->pixels.begin());
+			submit(copy);
+		}
+	}
+
+	RecordingStats Recorder::getStats() {
+		std::lock_guard<std::mutex> guard(mutex);
+		return stats;
+	}
+
+	long long Recorder::getBufferBytes() {
+		std::lock_guard<std::mutex> guard(mutex);
+		long long total = 0;
+		for (std::unique_ptr<Render::Framebuffer> const& buffer : buffers) {
+			total += (long long)(buffer->pixels.capacity() * sizeof(Render::Pixel));
+		}
+		return total;
+	}
+
+	void Recorder::encoderLoop() {
+		while (true) {
+			Render::Framebuffer* frame;
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [this] { return stopping || !queue.empty(); });
+				if (queue.empty()) {
+					break;
+				}
+				frame = queue.front();
+				queue.pop_front();
+			}
+
+			if (!failed) {
+				encode(*frame);
+			}
+
+			std::lock_guard<std::mutex> guard(mutex);
+			freeBuffers.push_back(frame);
+			if (failed) {
+				stats.failed = true;
+				stats.framesDropped++;
+			}
+			else {
+				stats.framesWritten++;
+				stats.width = width;
+				stats.height = height;
+			}
+		}
+		finishFile();
+	}
+
+	void Recorder::encode(Render::Framebuffer const& frame) {
+		Trace::Span span("encode frame", "export");
+		if (width == 0) {
+			width = frame.width;
+			height = frame.height;
+			paddedRow.assign(width, 0xff000000u);
+			if (format == RECORDING_FORMAT::Y4M) {
+				std::string header = "YUV4MPEG2 W" + std::to_string(width) + " H" + std::to_string(height) + " F" +
+					std::to_string(framerate) + ":1 Ip A1:1 C420jpeg\n";
+				write((uint8_t const*)header.data(), header.size());
+			}
+			else if (format == RECORDING_FORMAT::APNG) {
+				png = std::make_unique<PngWriter>([this](uint8_t const* data, size_t size) { write(data, size); }, width, height);
+				png->beginAnimation(1);// The real count is patched in when the recording stops
+			}
+		}
+
+		switch (format) {
+		case RECORDING_FORMAT::RAW:
+			output.resize(4 * (size_t)width);
+			for (int y = 0; y < height; y++) {
+				Render::Pixel const* row = frameRow(frame, y);
+				uint8_t* out = output.data();
+				for (int x = 0; x < width; x++) {
+					*out++ = (uint8_t)(row[x] >> 16);
+					*out++ = (uint8_t)(row[x] >> 8);
+					*out++ = (uint8_t)row[x];
+					*out++ = (uint8_t)(row[x] >> 24);
+				}
+				write(output.data(), output.size());
+			}
+			break;
+		case RECORDING_FORMAT::Y4M: {
+			// BT.601 studio range, with each chroma sample the average of a 2x2 block.
+			int chromaWidth = (width + 1) / 2;
+			int chromaHeight = (height + 1) / 2;
+			size_t lumaSize = (size_t)width * height;
+			size_t chromaSize = (size_t)chromaWidth * chromaHeight;
+			output.assign(6 + lumaSize + 2 * chromaSize, 0);
+			std::copy("FRAME\n", "FRAME\n" + 6, output.begin());
+			uint8_t* luma = output.data() + 6;
+			uint8_t* u = luma + lumaSize;
+			uint8_t* v = u + chromaSize;
+			std::vector<int> sumR(chromaWidth), sumG(chromaWidth), sumB(chromaWidth), weight(chromaWidth);
+			for (int y = 0; y < height; y++) {
+				Render::Pixel const* row = frameRow(frame, y);
+				for (int x = 0; x < width; x++) {
+					int r = (row[x] >> 16) & 0xff;
+					int g = (row[x] >> 8) & 0xff;
+					int b = row[x] & 0xff;
+					luma[(size_t)y * width + x] = (uint8_t)(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+					sumR[x / 2] += r;
+					sumG[x / 2] += g;
+					sumB[x / 2] += b;
+					weight[x / 2]++;
+				}
+				if (y % 2 == 1 || y == height - 1) {
+					for (int cx = 0; cx < chromaWidth; cx++) {
+						int r = sumR[cx] / weight[cx];
+						int g = sumG[cx] / weight[cx];
+						int b = sumB[cx] / weight[cx];
+						u[(size_t)(y / 2) * chromaWidth + cx] = (uint8_t)(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+						v[(size_t)(y / 2) * chromaWidth + cx] = (uint8_t)(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+						sumR[cx] = sumG[cx] = sumB[cx] = weight[cx] = 0;
+					}
+				}
+			}
+			write(output.data(), output.size());
+			break;
+		}
+		case RECORDING_FORMAT::APNG:
+			png->beginFrame(1, framerate);
+			for (int y = 0; y < height; y++) {
+				png->writeRow(frameRow(frame, y));
+			}
+			break;
+		}
+	}
+
+	void Recorder::finishFile() {
+		if (!failed && png) {
+			png->finish();
+			long long frames;
+			{
+				std::lock_guard<std::mutex> guard(mutex);
+				frames = stats.framesWritten;
+			}
+			uint8_t chunk[PNG_ANIMATION_CONTROL_SIZE];
+			makeAnimationControl((int)frames, 0, chunk);
+			file.seekp(PNG_ANIMATION_CONTROL_OFFSET);
+			write(chunk, sizeof(chunk));
+		}
+		file.close();
+		if (file.fail()) {
+			failed = true;
+		}
+		std::lock_guard<std::mutex> guard(mutex);
+		stats.failed = stats.failed || failed;
+	}
+
+	Render::Pixel const* Recorder::frameRow(Render::Framebuffer const& frame, int y) {
+		// A window resized mid-recording: keep the top left of the new size, and pad with black.
+		if (frame.width == width && y < frame.height) {
+			return frame.row(y);
+		}
+		std::fill(paddedRow.begin(), paddedRow.end(), 0xff000000u);
+		if (y < frame.height) {
+			std::copy(frame.row(y), frame.row(y) + (std::min)(width, frame.width), paddedRow.begin());
+		}
+		return paddedRow.data();
+	}
+
+	void Recorder::write(uint8_t const* data, size_t size) {
+		if (failed) { return; }
+		file.write((char const*)data, size);
+		if (!file) {
+			failed = true;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../standard.h"
+#include "../render/framebuffer.h"
+#include "png.h"
+
+
+namespace SimplePlot {
+	struct RecordingStats {
+		long long framesWritten = 0;
+		long long framesDropped = 0;// Offered while the encoder was behind, or after a write failed
+		int width = 0;// Fixed by the first frame; later frames are cropped or padded to it
+		int height = 0;
+		bool failed = false;// The file could not be opened or written
+	};
+
+	namespace Export {
+		// Writes a sequence of frames to a file on a background thread. The render side borrows a buffer,
+		// fills it and hands it over; there are only queueSize buffers, so when the encoder falls behind
+		// acquire returns nullptr straight away and the frame is dropped and counted rather than waited for.
+		class Recorder {
+		public:
+			Recorder(std::wstring const& path, RECORDING_FORMAT format, int framerate, int queueSize = SP_RECORDING_QUEUE);
+			~Recorder();
+			Recorder(Recorder const&) = delete;
+			Recorder& operator=(Recorder const&) = delete;
+
+			Render::Framebuffer* acquire(int width, int height);// nullptr if the frame should be dropped
+			void submit(Render::Framebuffer* frame);// Every acquired buffer must be submitted
+			void submitCopy(Render::Framebuffer const& frame);
+			RecordingStats getStats();
+			long long getBufferBytes();// The pooled frames
+			void stop();// Encodes whatever is queued, then closes the file. The destructor stops too.
+
+		private:
+			void encoderLoop();
+			void encode(Render::Framebuffer const& frame);
+			void finishFile();
+			Render::Pixel const* frameRow(Render::Framebuffer const& frame, int y);
+			void write(uint8_t const* data, size_t size);
+
+			RECORDING_FORMAT format;
+			int framerate;
+			int queueSize;
+
+			std::mutex mutex;
+			std::condition_variable wake;
+			std::deque<Render::Framebuffer*> queue;
+			std::vector<std::unique_ptr<Render::Framebuffer>> buffers;
+			std::vector<Render::Framebuffer*> freeBuffers;
+			bool stopping = false;
+			RecordingStats stats;
+
+			// Only touched by the encoder thread
+			std::ofstream file;
+			std::unique_ptr<PngWriter> png;
+			std::vector<uint8_t> output;
+			std::vector<Render::Pixel> paddedRow;
+			bool failed = false;
+			int width = 0;
+			int height = 0;
+
+			std::thread thread;// Last, so that everything it uses exists before it starts
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#include "simplify.h"
+
+
+namespace SimplePlot::Export {
+	namespace {
+		float squaredSegmentDistance(float const* p, float const* a, float const* b) {
+			float dx = b[0] - a[0];
+			float dy = b[1] - a[1];
+			float lengthSquared = dx * dx + dy * dy;
+			float t = 0;
+			if (lengthSquared > 0) {
+				t = ((p[0] - a[0]) * dx + (p[1] - a[1]) * dy) / lengthSquared;
+				t = t < 0 ? 0 : (t > 1 ? 1 : t);
+			}
+			float ex = a[0] + t * dx - p[0];
+			float ey = a[1] + t * dy - p[1];
+			return ex * ex + ey * ey;
+		}
+	}
+
+	Simplifier::Simplifier(float tolerance) : tolerance(tolerance) {}
+
+	int Simplifier::simplify(float const* points, int count, std::vector<float>& out) {
+		if (count <= 2 || tolerance <= 0) {
+			out.insert(out.end(), points, points + 2 * (size_t)count);
+			return count;
+		}
+
+		float half = tolerance / 2;
+		float radial = half * half;
+		reduced.clear();
+		reduced.push_back(points[0]);
+		reduced.push_back(points[1]);
+		for (int i = 1; i < count - 1; i++) {
+			float dx = points[2 * i] - reduced[reduced.size() - 2];
+			float dy = points[2 * i + 1] - reduced[reduced.size() - 1];
+			if (dx * dx + dy * dy > radial) {
+				reduced.push_back(points[2 * i]);
+				reduced.push_back(points[2 * i + 1]);
+			}
+		}
+		reduced.push_back(points[2 * (count - 1)]);
+		reduced.push_back(points[2 * (count - 1) + 1]);
+
+		// Douglas-Peucker with an explicit stack, since a long series would recurse too deeply.
+		int n = (int)(reduced.size() / 2);
+		float const* r = reduced.data();
+		keep.assign(n, 0);
+		keep[0] = 1;
+		keep[n - 1] = 1;
+		stack.clear();
+		stack.push_back({ 0, n - 1 });
+		while (!stack.empty()) {
+			std::pair<int, int> range = stack.back();
+			stack.pop_back();
+			float worst = radial;
+			int split = -1;
+			for (int i = range.first + 1; i < range.second; i++) {
+				float d = squaredSegmentDistance(r + 2 * i, r + 2 * range.first, r + 2 * range.second);
+				if (d > worst) {
+					worst = d;
+					split = i;
+				}
+			}
+			if (split >= 0) {
+				keep[split] = 1;
+				stack.push_back({ range.first, split });
+				stack.push_back({ split, range.second });
+			}
+		}
+
+		int kept = 0;
+		for (int i = 0; i < n; i++) {
+			if (keep[i]) {
+				out.push_back(r[2 * i]);
+				out.push_back(r[2 * i + 1]);
+				kept++;
+			}
+		}
+		return kept;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+namespace SimplePlot::Export {
+	// Reduces a polyline to the points needed to draw it to within a tolerance, in the same units as the
+	// points (pixels, for a draw list). A radial pass first drops points closer than half the tolerance to
+	// the last one kept, which collapses the many samples a dense series puts in each pixel in linear time;
+	// Ramer-Douglas-Peucker with the other half then removes what lies along straight stretches. Every
+	// original point ends up within the tolerance of the result, and the ends are always kept.
+	class Simplifier {
+	public:
+		Simplifier(float tolerance);
+
+		// Appends the kept x, y pairs to out and returns how many points were appended.
+		int simplify(float const* points, int count, std::vector<float>& out);
+
+	private:
+		float tolerance;
+		std::vector<float> reduced;// Survivors of the radial pass
+		std::vector<char> keep;
+		std::vector<std::pair<int, int>> stack;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,287 @@
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+
+#include "svg.h"
+#include "png.h"
+#include "simplify.h"
+#include "../canvas.h"
+#include "../trace.h"
+
+
+namespace SimplePlot {
+	namespace Export {
+		namespace {
+			const size_t OUTPUT_BATCH = 1 << 16;
+
+			class SvgWriter {
+			public:
+				SvgWriter(Sink sink, float tolerance) : sink(sink), simplifier(tolerance) {
+					buffer.reserve(OUTPUT_BATCH + 256);
+				}
+
+				void write(Render::DrawList const& list, int width, int height) {
+					put("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<svg xmlns=\"http://www.w3.org/2000/svg\" "
+						"xmlns:xlink=\"http://www.w3.org/1999/xlink\" width=\"");
+					putInt(width);
+					put("\" height=\"");
+					putInt(height);
+					put("\" viewBox=\"0 0 ");
+					putInt(width);
+					put(" ");
+					putInt(height);
+					put("\">\n");
+
+					size_t i = 0;
+					while (i < list.primitives.size()) {
+						Render::Primitive const& prim = list.primitives[i];
+						float const* p = list.points.data() + 2 * (size_t)prim.first;
+						switch (prim.type) {
+						case Render::PRIMITIVE::RECT:
+							writeRect(p, prim.color);
+							i++;
+							break;
+						case Render::PRIMITIVE::IMAGE: {
+							Render::Image const& image = list.images[prim.image];
+							writeImage(image.left, image.top, image.width, image.height, [&image](int y, Render::Pixel* row) {
+								std::copy(image.pixels.begin() + (size_t)y * image.width, image.pixels.begin() + (size_t)(y + 1) * image.width, row);
+							});
+							i++;
+							break;
+						}
+						case Render::PRIMITIVE::MASK: {
+							Render::Mask const& mask = *list.masks[prim.image];
+							Render::Pixel color = prim.color & 0xffffff;
+							writeImage((int)p[0], (int)p[1], mask.width, mask.height, [&mask, color](int y, Render::Pixel* row) {
+								uint8_t const* coverage = mask.coverage.data() + (size_t)y * mask.width;
+								for (int x = 0; x < mask.width; x++) {
+									row[x] = color | ((Render::Pixel)coverage[x] << 24);
+								}
+							});
+							i++;
+							break;
+						}
+						case Render::PRIMITIVE::POLYLINE:
+							i = writePath(list, i);
+							break;
+						}
+					}
+					put("</svg>\n");
+					flush();
+				}
+
+			private:
+				void writeRect(float const* p, Render::Pixel color) {
+					put("<rect x=\"");
+					putCoordinate((std::min)(p[0], p[2]));
+					put("\" y=\"");
+					putCoordinate((std::min)(p[1], p[3]));
+					put("\" width=\"");
+					putCoordinate(std::fabs(p[2] - p[0]));
+					put("\" height=\"");
+					putCoordinate(std::fabs(p[3] - p[1]));
+					put("\" fill=\"");
+					putColor(color);
+					put("\"");
+					putOpacity("fill-opacity", color);
+					put("/>\n");
+				}
+
+				template<typename RowFunction>
+				void writeImage(int left, int top, int width, int height, RowFunction fillRow) {
+					if (width <= 0 || height <= 0) { return; }
+					put("<image x=\"");
+					putInt(left);
+					put("\" y=\"");
+					putInt(top);
+					put("\" width=\"");
+					putInt(width);
+					put("\" height=\"");
+					putInt(height);
+					put("\" xlink:href=\"data:image/png;base64,");
+					{
+						PngWriter png([this](uint8_t const* data, size_t size) { putBase64(data, size); }, width, height, true);
+						std::vector<Render::Pixel> row(width);
+						for (int y = 0; y < height; y++) {
+							fillRow(y, row.data());
+							png.writeRow(row.data());
+						}
+						png.finish();
+					}
+					finishBase64();
+					put("\"/>\n");
+				}
+
+				size_t writePath(Render::DrawList const& list, size_t i) {
+					// Pixel centres are at integer coordinates in a draw list, and at half integers in SVG.
+					Render::Primitive const& first = list.primitives[i];
+					put("<path fill=\"none\" stroke=\"");
+					putColor(first.color);
+					put("\"");
+					putOpacity("stroke-opacity", first.color);
+					put(" stroke-width=\"");
+					putInt(first.width);
+					put("\" stroke-linecap=\"round\" stroke-linejoin=\"round\" d=\"");
+					for (; i < list.primitives.size(); i++) {
+						Render::Primitive const& prim = list.primitives[i];
+						if (prim.type != Render::PRIMITIVE::POLYLINE || prim.color != first.color || prim.width != first.width) {
+							break;
+						}
+						simplified.clear();
+						int count = simplifier.simplify(list.points.data() + 2 * (size_t)prim.first, prim.count, simplified);
+						long long x = toHundredths(simplified[0] + 0.5f);
+						long long y = toHundredths(simplified[1] + 0.5f);
+						put("M");
+						putHundredths(x);
+						put(" ");
+						putHundredths(y);
+						// Relative steps, measured from the rounded previous point so that rounding never accumulates.
+						for (int k = 1; k < count; k++) {
+							long long nextX = toHundredths(simplified[2 * k] + 0.5f);
+							long long nextY = toHundredths(simplified[2 * k + 1] + 0.5f);
+							put(k == 1 ? "l" : " ");
+							putHundredths(nextX - x);
+							put(" ");
+							putHundredths(nextY - y);
+							x = nextX;
+							y = nextY;
+						}
+					}
+					put("\"/>\n");
+					return i;
+				}
+
+				static long long toHundredths(float v) {
+					return std::llround((double)v * 100);
+				}
+
+				void putHundredths(long long v) {
+					char text[24];
+					char* end = text + sizeof(text);
+					char* p = end;
+					bool negative = v < 0;
+					unsigned long long u = negative ? 0ull - (unsigned long long)v : (unsigned long long)v;
+					unsigned int fraction = (unsigned int)(u % 100);
+					u /= 100;
+					if (fraction != 0) {
+						if (fraction % 10 != 0) {
+							*--p = (char)('0' + fraction % 10);
+						}
+						*--p = (char)('0' + fraction / 10);
+						*--p = '.';
+					}
+					do {
+						*--p = (char)('0' + u % 10);
+						u /= 10;
+					} while (u > 0);
+					if (negative) {
+						*--p = '-';
+					}
+					buffer.insert(buffer.end(), p, end);
+					flushIfFull();
+				}
+
+				void putCoordinate(float v) {
+					putHundredths(toHundredths(v));
+				}
+
+				void putInt(long long v) {
+					putHundredths(v * 100);
+				}
+
+				void putColor(Render::Pixel color) {
+					static const char digits[] = "0123456789abcdef";
+					char text[7] = { '#' };
+					for (int i = 0; i < 6; i++) {
+						text[1 + i] = digits[(color >> (20 - 4 * i)) & 0xf];
+					}
+					buffer.insert(buffer.end(), text, text + 7);
+				}
+
+				void putOpacity(char const* attribute, Render::Pixel color) {
+					unsigned int alpha = color >> 24;
+					if (alpha == 255) { return; }
+					put(" ");
+					put(attribute);
+					put("=\"");
+					putHundredths(std::lround(alpha * 100.0 / 255));
+					put("\"");
+				}
+
+				void putBase64(uint8_t const* data, size_t size) {
+					// Carries up to two bytes between calls, since the PNG encoder hands over arbitrary pieces.
+					for (size_t i = 0; i < size; i++) {
+						pending[pendingCount++] = data[i];
+						if (pendingCount == 3) {
+							putBase64Group(3);
+						}
+					}
+					flushIfFull();
+				}
+
+				void finishBase64() {
+					if (pendingCount > 0) {
+						putBase64Group(pendingCount);
+					}
+				}
+
+				void putBase64Group(int count) {
+					static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+					uint32_t group = (uint32_t)pending[0] << 16;
+					group |= count > 1 ? (uint32_t)pending[1] << 8 : 0;
+					group |= count > 2 ? (uint32_t)pending[2] : 0;
+					buffer.push_back(alphabet[(group >> 18) & 0x3f]);
+					buffer.push_back(alphabet[(group >> 12) & 0x3f]);
+					buffer.push_back(count > 1 ? alphabet[(group >> 6) & 0x3f] : '=');
+					buffer.push_back(count > 2 ? alphabet[group & 0x3f] : '=');
+					pendingCount = 0;
+				}
+
+				void put(char const* text) {
+					while (*text) {
+						buffer.push_back(*text++);
+					}
+					flushIfFull();
+				}
+
+				void flushIfFull() {
+					if (buffer.size() >= OUTPUT_BATCH) {
+						flush();
+					}
+				}
+
+				void flush() {
+					if (!buffer.empty()) {
+						sink((uint8_t const*)buffer.data(), buffer.size());
+						buffer.clear();
+					}
+				}
+
+				Sink sink;
+				Simplifier simplifier;
+				std::vector<float> simplified;
+				std::vector<char> buffer;
+				uint8_t pending[3] = {};
+				int pendingCount = 0;
+			};
+		}
+
+		void writeSVG(Render::DrawList const& list, int width, int height, float tolerance, Sink sink) {
+			Trace::Span span("svg", "export");
+			SvgWriter writer(sink, tolerance);
+			writer.write(list, width, height);
+		}
+	}
+
+	bool renderCanvasToSVG(CANVAS_ID id, std::wstring const& path, int width, int height, float tolerance) {
+		std::ofstream file(std::filesystem::path(path), std::ios::binary);
+		if (!file) {
+			return false;
+		}
+		renderCanvasSVG(id, [&file](uint8_t const* data, size_t size) {
+			file.write((char const*)data, size);
+		}, width, height, tolerance);
+		file.close();
+		return !file.fail();
+	}
+}
\ No newline at end of file
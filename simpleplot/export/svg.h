@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+
+#include "../standard.h"
+#include "../render/drawlist.h"
+#include "deflate.h"
+
+
+namespace SimplePlot {
+	namespace Export {
+		// Writes a draw list as SVG in a single pass, in the order it would be rasterized. Polylines are
+		// simplified to within tolerance pixels of the given size, and each run of consecutive polylines in
+		// one colour and width becomes a single path, so the size of the file follows what can be seen rather
+		// than the number of samples. Images and text masks are embedded as PNG.
+		void writeSVG(Render::DrawList const& list, int width, int height, float tolerance, Sink sink);
+	}
+
+	// tolerance is in pixels of the width x height the figure is laid out at; the SVG scales from there.
+	bool renderCanvasToSVG(CANVAS_ID id, std::wstring const& path, int width, int height, float tolerance = SP_SVG_TOLERANCE);
+}
\ No newline at end of file
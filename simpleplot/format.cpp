@@ -0,0 +1,198 @@
+#include "format.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+
+namespace SimplePlot::Format {
+	namespace {
+		const int maxPrecision = 17;
+		// SI prefixes from 1e-24 to 1e24, one per power of 1000. 'u' stands in for micro in narrow strings.
+		const char siPrefixes[] = "yzafpnum kMGTPEZY";
+		const int siZero = 8;// Index of the empty prefix
+
+		// Splits value into mantissa * 10^exponent, where the exponent is a multiple of step and the mantissa,
+		// once rounded to precision digits, lies in [1, 10^step).
+		void split(double value, int step, int precision, double& mantissa, int& exponent) {
+			if (value == 0) {
+				mantissa = 0;
+				exponent = 0;
+				return;
+			}
+			exponent = (int)std::floor(std::log10(std::fabs(value)));
+			exponent -= ((exponent % step) + step) % step;
+			mantissa = value / std::pow(10.0, exponent);
+			// Rounding can carry the mantissa up to the next power, e.g. 9.996 with two digits.
+			double scale = std::pow(10.0, precision);
+			if (std::fabs(std::round(mantissa * scale) / scale) >= std::pow(10.0, step)) {
+				exponent += step;
+				mantissa = value / std::pow(10.0, exponent);
+			}
+		}
+
+		// Digits after the point needed to write x exactly, allowing for noise in the last few bits.
+		int neededDecimals(double x) {
+			for (int d = 0; d < maxPrecision; d++) {
+				double scaled = x * std::pow(10.0, d);
+				if (std::fabs(scaled - std::round(scaled)) <= 1e-9 * (std::max)(1.0, std::fabs(scaled))) {
+					return d;
+				}
+			}
+			return maxPrecision;
+		}
+
+		// Formats into a narrow buffer and reports where the SI prefix, if any, was written.
+		int formatNarrow(double value, NUMBER_FORMAT format, int precision, char* buffer, int size, int& prefixAt) {
+			prefixAt = -1;
+			if (size <= 0) { return 0; }
+			precision = (std::max)(0, (std::min)(precision, maxPrecision));
+			if (value == 0) { value = 0; }// Drop the sign of -0
+			char* end = buffer + size - 1;// Room for the null
+			std::to_chars_result result = { buffer, std::errc() };
+
+			if (!std::isfinite(value)) {
+				result = std::to_chars(buffer, end, value);
+			}
+			else {
+				switch (format) {
+				case NUMBER_FORMAT::SHORTEST:
+					result = std::to_chars(buffer, end, value);
+					break;
+				case NUMBER_FORMAT::SCIENTIFIC:
+				case NUMBER_FORMAT::ENGINEERING:
+				case NUMBER_FORMAT::SI: {
+					double mantissa;
+					int exponent;
+					split(value, format == NUMBER_FORMAT::SCIENTIFIC ? 1 : 3, precision, mantissa, exponent);
+					result = std::to_chars(buffer, end, mantissa, std::chars_format::fixed, precision);
+					if (result.ec != std::errc() || exponent == 0) { break; }
+					int prefix = siZero + exponent / 3;
+					if (format == NUMBER_FORMAT::SI && prefix >= 0 && prefix < (int)sizeof(siPrefixes) - 1) {
+						if (result.ptr == end) { result.ec = std::errc::value_too_large; break; }
+						prefixAt = (int)(result.ptr - buffer);
+						*result.ptr++ = siPrefixes[prefix];
+					}
+					else {
+						if (result.ptr == end) { result.ec = std::errc::value_too_large; break; }
+						*result.ptr++ = 'e';
+						result = std::to_chars(result.ptr, end, exponent);
+					}
+					break;
+				}
+				case NUMBER_FORMAT::AUTO:
+				case NUMBER_FORMAT::FIXED:
+				default:
+					if (std::round(value * std::pow(10.0, precision)) == 0) {
+						value = 0;// Don't write -0.00 for tiny negative numbers
+					}
+					result = std::to_chars(buffer, end, value, std::chars_format::fixed, precision);
+					if (result.ec != std::errc()) {
+						// Too many digits before the point, from about 1e38 on. Scientific always fits, with as
+						// many digits as the mantissa needs, since the fixed precision says nothing about them.
+						double mantissa;
+						int exponent;
+						split(value, 1, maxPrecision, mantissa, exponent);
+						return formatNarrow(value, NUMBER_FORMAT::SCIENTIFIC, neededDecimals(mantissa), buffer, size, prefixAt);
+					}
+					break;
+				}
+			}
+
+			if (result.ec != std::errc()) {
+				buffer[0] = 0;
+				return 0;
+			}
+			*result.ptr = 0;
+			return (int)(result.ptr - buffer);
+		}
+	}
+
+	int formatNumber(double value, NUMBER_FORMAT format, int precision, char* buffer, int size) {
+		int prefixAt;
+		return formatNarrow(value, format, precision, buffer, size, prefixAt);
+	}
+
+	int formatNumber(double value, NUMBER_FORMAT format, int precision, wchar_t* buffer, int size) {
+		char narrow[SP_FORMAT_BUFFER_SIZE];
+		int prefixAt;
+		int length = formatNarrow(value, format, precision, narrow, (std::min)(size, SP_FORMAT_BUFFER_SIZE), prefixAt);
+		for (int i = 0; i < length; i++) {
+			buffer[i] = i == prefixAt && narrow[i] == 'u' ? L'\u00b5' : (wchar_t)narrow[i];
+		}
+		if (size > 0) {
+			buffer[length] = 0;
+		}
+		return length;
+	}
+
+	int commonPrecision(double const* values, int count, NUMBER_FORMAT format) {
+		if (format == NUMBER_FORMAT::SHORTEST) { return 0; }
+		format = resolveFormat(values, count, format);
+		int precision = 0;
+		for (int i = 0; i < count; i++) {
+			if (!std::isfinite(values[i]) || values[i] == 0) { continue; }
+			double digits = values[i];
+			if (format != NUMBER_FORMAT::FIXED) {
+				double mantissa;
+				int exponent;
+				split(values[i], format == NUMBER_FORMAT::SCIENTIFIC ? 1 : 3, maxPrecision, mantissa, exponent);
+				digits = mantissa;
+			}
+			precision = (std::max)(precision, neededDecimals(digits));
+		}
+		return precision;
+	}
+
+	int stepPrecision(double const* values, int count, double step, NUMBER_FORMAT format) {
+		if (format == NUMBER_FORMAT::SHORTEST || !(step > 0) || !std::isfinite(step)) { return 0; }
+		format = resolveFormat(values, count, format);
+		// Labels a step apart differ in the step's leading digit, so that is the last digit each one needs.
+		int stepExponent = (int)std::floor(std::log10(step) + 1e-9);
+		int stepDecimals = neededDecimals(step / std::pow(10.0, stepExponent));
+		int precision = 0;
+		if (format == NUMBER_FORMAT::FIXED) {
+			precision = stepDecimals - stepExponent;
+		}
+		else {
+			for (int i = 0; i < count; i++) {
+				if (!std::isfinite(values[i]) || values[i] == 0) { continue; }
+				double mantissa;
+				int exponent;
+				split(values[i], format == NUMBER_FORMAT::SCIENTIFIC ? 1 : 3, maxPrecision, mantissa, exponent);
+				precision = (std::max)(precision, exponent - stepExponent + stepDecimals);
+			}
+		}
+		precision = (std::max)(0, (std::min)(precision, maxPrecision));
+
+		// Rounding can still merge neighbours, e.g. where a mantissa carries into the next exponent.
+		for (int i = 1; i < count && precision < maxPrecision; i++) {
+			char previous[SP_FORMAT_BUFFER_SIZE];
+			char current[SP_FORMAT_BUFFER_SIZE];
+			int prefixAt;
+			formatNarrow(values[i - 1], format, precision, previous, SP_FORMAT_BUFFER_SIZE, prefixAt);
+			formatNarrow(values[i], format, precision, current, SP_FORMAT_BUFFER_SIZE, prefixAt);
+			if (values[i] != values[i - 1] && std::strcmp(previous, current) == 0) {
+				precision++;
+				i = 0;// Start over, since the earlier pairs were checked at the old precision
+			}
+		}
+		return precision;
+	}
+
+	NUMBER_FORMAT resolveFormat(double const* values, int count, NUMBER_FORMAT format) {
+		if (format != NUMBER_FORMAT::AUTO) { return format; }
+		double largest = 0;
+		double smallest = HUGE_VAL;
+		for (int i = 0; i < count; i++) {
+			double magnitude = std::fabs(values[i]);
+			if (!std::isfinite(magnitude) || magnitude == 0) { continue; }
+			largest = (std::max)(largest, magnitude);
+			smallest = (std::min)(smallest, magnitude);
+		}
+		if (largest == 0) { return NUMBER_FORMAT::FIXED; }
+		// Fixed point stops being readable past about seven digits either side of the point.
+		return largest >= 1e7 || smallest < 1e-4 ? NUMBER_FORMAT::SCIENTIFIC : NUMBER_FORMAT::FIXED;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+#include "standard.h"
+
+
+namespace SimplePlot::Format {
+	// Writes value into buffer with precision digits after the point (ignored by SHORTEST) and returns the
+	// number of characters written, not counting the terminating null. Nothing is allocated. Returns 0,
+	// leaving an empty string, if the buffer is too small; SP_FORMAT_BUFFER_SIZE is always enough, since FIXED
+	// values too long for it are written as SCIENTIFIC instead.
+	int formatNumber(double value, NUMBER_FORMAT format, int precision, char* buffer, int size);
+	int formatNumber(double value, NUMBER_FORMAT format, int precision, wchar_t* buffer, int size);
+
+	// The fewest digits after the point that show every value exactly (to within rounding noise) in the given
+	// format, so that a set of labels such as tick numbers can share one precision. One pass over the values.
+	int commonPrecision(double const* values, int count, NUMBER_FORMAT format);
+
+	// The digits after the point that tell apart values spaced step apart, such as ticks: the step's own digits
+	// in FIXED, or each value's exponent less the step's in the other formats. Widened until no two adjacent
+	// values share a label, so that large values with a small spread don't all print as the same number.
+	int stepPrecision(double const* values, int count, double step, NUMBER_FORMAT format);
+
+	// Resolves AUTO to FIXED or SCIENTIFIC for a set of values; other formats are returned unchanged.
+	NUMBER_FORMAT resolveFormat(double const* values, int count, NUMBER_FORMAT format);
+}
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "link.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+
+namespace SimplePlot {
+	namespace Maps {
+		std::map<LINK_ID, std::shared_ptr<Link::AxisLink>> linkPointerMap;
+		std::mutex linkMapMutex;
+	}
+
+	namespace Link {
+		AxisLink::AxisLink() {
+			id = maxID++;
+		}
+
+		void AxisLink::share(CANVAS_ID canvas, int axisNum, long long origin_, double& low, double& high) {
+			std::lock_guard<std::mutex> guard(mutex);
+			if (!hasOrigin) {
+				origin = origin_;
+				hasOrigin = true;
+			}
+			// Origins are whole nanoseconds apart, so the shift is exact whatever their size.
+			double shift = (double)(origin_ - origin);
+
+			auto it = std::find_if(members.begin(), members.end(), [&](Member const& m) {
+				return m.canvas == canvas && m.axisNum == axisNum;
+			});
+			if (it == members.end()) {
+				members.push_back({ canvas, axisNum, low + shift, high + shift });
+				extentValid = false;
+			}
+			else if (it->low != low + shift || it->high != high + shift) {
+				it->low = low + shift;
+				it->high = high + shift;
+				extentValid = false;
+			}
+
+			double sharedLow, sharedHigh;
+			currentRange(sharedLow, sharedHigh);
+			low = sharedLow - shift;
+			high = sharedHigh - shift;
+		}
+
+		void AxisLink::leave(CANVAS_ID canvas, int axisNum) {
+			std::lock_guard<std::mutex> guard(mutex);
+			auto it = std::find_if(members.begin(), members.end(), [&](Member const& m) {
+				return m.canvas == canvas && m.axisNum == axisNum;
+			});
+			if (it != members.end()) {
+				members.erase(it);
+				extentValid = false;
+			}
+		}
+
+		void AxisLink::setRange(double low, double high) {
+			std::lock_guard<std::mutex> guard(mutex);
+			if (!(low < high)) { return; }
+			viewLow = low - origin;
+			viewHigh = high - origin;
+			viewSet = true;
+		}
+
+		void AxisLink::zoom(double factor) {
+			std::lock_guard<std::mutex> guard(mutex);
+			if (!(factor > 0)) { return; }
+			double low, high;
+			currentRange(low, high);
+			double middle = (low + high) / 2;
+			double halfWidth = (high - low) / 2 / factor;
+			viewLow = middle - halfWidth;
+			viewHigh = middle + halfWidth;
+			viewSet = true;
+		}
+
+		void AxisLink::pan(double fraction) {
+			std::lock_guard<std::mutex> guard(mutex);
+			double low, high;
+			currentRange(low, high);
+			double shift = (high - low) * fraction;
+			viewLow = low + shift;
+			viewHigh = high + shift;
+			viewSet = true;
+		}
+
+		void AxisLink::reset() {
+			std::lock_guard<std::mutex> guard(mutex);
+			viewSet = false;
+		}
+
+		void AxisLink::currentRange(double& low, double& high) {
+			// Called with the mutex held.
+			if (viewSet) {
+				low = viewLow;
+				high = viewHigh;
+				return;
+			}
+			if (!extentValid) {
+				extentLow = HUGE_VAL;
+				extentHigh = -HUGE_VAL;
+				for (Member const& m : members) {
+					extentLow = (std::min)(extentLow, m.low);
+					extentHigh = (std::max)(extentHigh, m.high);
+				}
+				if (members.empty()) {
+					extentLow = 0;
+					extentHigh = 1;
+				}
+				extentValid = true;
+			}
+			low = extentLow;
+			high = extentHigh;
+		}
+
+		std::shared_ptr<AxisLink> getLink(LINK_ID id) {
+			std::lock_guard<std::mutex> guard(Maps::linkMapMutex);
+			auto it = Maps::linkPointerMap.find(id);
+			return it == Maps::linkPointerMap.end() ? nullptr : it->second;
+		}
+	}
+
+	namespace {
+		std::shared_ptr<Link::AxisLink> linkAt(LINK_ID id) {
+			std::lock_guard<std::mutex> guard(Maps::linkMapMutex);
+			return Maps::linkPointerMap.at(id);
+		}
+	}
+
+	LINK_ID makeAxisLink() {
+		std::shared_ptr<Link::AxisLink> link = std::make_shared<Link::AxisLink>();
+		std::lock_guard<std::mutex> guard(Maps::linkMapMutex);
+		Maps::linkPointerMap[link->id] = link;
+		return link->id;
+	}
+
+	void deleteAxisLink(LINK_ID id) {
+		// Canvases still bound to the link find it gone on their next frame and go back to their own range.
+		std::lock_guard<std::mutex> guard(Maps::linkMapMutex);
+		Maps::linkPointerMap.erase(id);
+	}
+
+	void setAxisLinkRange(LINK_ID id, double low, double high) {
+		linkAt(id)->setRange(low, high);
+	}
+
+	void zoomAxisLink(LINK_ID id, double factor) {
+		linkAt(id)->zoom(factor);
+	}
+
+	void panAxisLink(LINK_ID id, double fraction) {
+		linkAt(id)->pan(fraction);
+	}
+
+	void resetAxisLink(LINK_ID id) {
+		linkAt(id)->reset();
+	}
+}
\ No newline at end of file
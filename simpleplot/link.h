@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "standard.h"
+
+
+namespace SimplePlot {
+	namespace Link {
+		// A range shared by one axis on each of several canvases. Every canvas reports the extent of its own
+		// data as it draws, and gets back the union of all the members' extents, or the view set by a zoom or
+		// pan. The union is only recomputed when some member's extent has changed, so a dashboard of canvases
+		// with a common x axis agrees on the range without any canvas looking at another's data.
+		class AxisLink {
+		public:
+			AxisLink();
+
+			// Swaps the canvas's own [low, high] for the shared range. Both are relative to origin, the
+			// canvas axis's origin, on the way in and on the way out.
+			void share(CANVAS_ID canvas, int axisNum, long long origin, double& low, double& high);
+			void leave(CANVAS_ID canvas, int axisNum);
+
+			void setRange(double low, double high);// In data units
+			void zoom(double factor);// > 1 zooms in, about the middle of the current range
+			void pan(double fraction);// Moves by a fraction of the current range; positive moves towards higher values
+			void reset();// Follow the data again
+
+			LINK_ID id = SP_NULL_LINK;
+
+		private:
+			struct Member {
+				CANVAS_ID canvas;
+				int axisNum;
+				double low;// Relative to the link's origin
+				double high;
+			};
+
+			void currentRange(double& low, double& high);
+
+			std::vector<Member> members;
+			long long origin = 0;// Where member extents are measured from; the first member's origin
+			bool hasOrigin = false;
+			bool extentValid = false;
+			double extentLow = 0;
+			double extentHigh = 1;
+			bool viewSet = false;
+			double viewLow = 0;
+			double viewHigh = 1;
+			std::mutex mutex;
+
+			inline static std::atomic<LINK_ID> maxID = 0;// Links can be made from several threads at once
+		};
+
+		std::shared_ptr<AxisLink> getLink(LINK_ID id);// nullptr once the link is deleted
+	}
+
+	LINK_ID makeAxisLink();
+	void deleteAxisLink(LINK_ID id);
+	void setAxisLinkRange(LINK_ID id, double low, double high);
+	void zoomAxisLink(LINK_ID id, double factor);
+	void panAxisLink(LINK_ID id, double fraction);
+	void resetAxisLink(LINK_ID id);
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#include "locks.h"
+
+
+namespace SimplePlot {
+	namespace Locks {
+		namespace {
+			// Sites register themselves during static initialisation, so the list is a function static.
+			std::mutex& sitesMutex() {
+				static std::mutex mutex;
+				return mutex;
+			}
+
+			std::vector<Site*>& sites() {
+				static std::vector<Site*> list;
+				return list;
+			}
+		}
+
+		Site::Site(char const* name) : name(name) {
+			std::lock_guard<std::mutex> guard(sitesMutex());
+			sites().push_back(this);
+		}
+
+		void Site::recordWait(long long nanoseconds) {
+			contended.fetch_add(1, std::memory_order_relaxed);
+			totalWait.fetch_add(nanoseconds, std::memory_order_relaxed);
+			long long longest = maxWait.load(std::memory_order_relaxed);
+			while (nanoseconds > longest && !maxWait.compare_exchange_weak(longest, nanoseconds, std::memory_order_relaxed)) {}
+		}
+	}
+
+	void setLockStatsEnabled(bool enabled) {
+		Locks::counting.store(enabled, std::memory_order_relaxed);
+	}
+
+	std::vector<LockStats> getLockStats() {
+		std::lock_guard<std::mutex> guard(Locks::sitesMutex());
+		std::vector<LockStats> stats;
+		for (Locks::Site const* site : Locks::sites()) {
+			LockStats entry;
+			entry.site = site->name;
+			entry.acquisitions = site->acquisitions.load(std::memory_order_relaxed);
+			entry.contended = site->contended.load(std::memory_order_relaxed);
+			entry.totalWait = site->totalWait.load(std::memory_order_relaxed) / 1e6;
+			entry.maxWait = site->maxWait.load(std::memory_order_relaxed) / 1e6;
+			stats.push_back(entry);
+		}
+		return stats;
+	}
+
+	void resetLockStats() {
+		std::lock_guard<std::mutex> guard(Locks::sitesMutex());
+		for (Locks::Site* site : Locks::sites()) {
+			site->acquisitions.store(0, std::memory_order_relaxed);
+			site->contended.store(0, std::memory_order_relaxed);
+			site->totalWait.store(0, std::memory_order_relaxed);
+			site->maxWait.store(0, std::memory_order_relaxed);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "trace.h"
+
+
+namespace SimplePlot {
+	struct LockStats {
+		std::string site;// Which guard, and which of its mutexes
+		long long acquisitions = 0;
+		long long contended = 0;// Acquisitions that had to wait
+		double totalWait = 0;// Milliseconds
+		double maxWait = 0;
+	};
+
+	// Counts acquisitions and waits on the registry and frame locks. Off by default; when off, taking a lock
+	// costs two relaxed loads more than a plain lock_guard.
+	void setLockStatsEnabled(bool enabled);
+	std::vector<LockStats> getLockStats();// One entry per site, in the order the sites were defined
+	void resetLockStats();
+
+	namespace Locks {
+		inline std::atomic<bool> counting = false;
+
+		// One place in the code that takes a lock. Sites are defined once, at namespace scope, and live for
+		// the whole run.
+		class Site {
+		public:
+			explicit Site(char const* name);
+			Site(Site const&) = delete;
+			Site& operator=(Site const&) = delete;
+
+			void recordWait(long long nanoseconds);
+
+			char const* const name;
+			std::atomic<long long> acquisitions = 0;
+			std::atomic<long long> contended = 0;
+			std::atomic<long long> totalWait = 0;// Nanoseconds
+			std::atomic<long long> maxWait = 0;
+		};
+
+		// A lock_guard that, when lock stats are on, counts the acquisition at its site and, when the mutex was
+		// contended, how long it waited. While tracing, contended waits are also written as spans.
+		class LockGuard {
+		public:
+			LockGuard(std::mutex& mutex, Site& site) : mutex(mutex) {
+				bool countNow = counting.load(std::memory_order_relaxed);
+				bool traceNow = Trace::isTracing();
+				if (!countNow && !traceNow) {
+					mutex.lock();
+					return;
+				}
+				if (countNow) { site.acquisitions.fetch_add(1, std::memory_order_relaxed); }
+				if (mutex.try_lock()) { return; }
+
+				Trace::Clock::time_point begin = Trace::Clock::now();
+				mutex.lock();
+				Trace::Clock::time_point end = Trace::Clock::now();
+				if (countNow) { site.recordWait(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count()); }
+				if (traceNow) { Trace::emit(site.name, "lock", begin, end, SP_TRACE_NO_ID); }
+			}
+			// For a mutex the caller already holds, taken with try_lock after waiting for it some other way:
+			// counts the acquisition, and waited nanoseconds as a contended wait when there were any.
+			LockGuard(std::mutex& mutex, Site& site, std::adopt_lock_t, long long waited) : mutex(mutex) {
+				if (!counting.load(std::memory_order_relaxed)) { return; }
+				site.acquisitions.fetch_add(1, std::memory_order_relaxed);
+				if (waited > 0) { site.recordWait(waited); }
+			}
+			~LockGuard() {
+				mutex.unlock();
+			}
+			LockGuard(LockGuard const&) = delete;
+			LockGuard& operator=(LockGuard const&) = delete;
+
+		private:
+			std::mutex& mutex;
+		};
+	}
+}
\ No newline at end of file
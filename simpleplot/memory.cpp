@@ -0,0 +1,106 @@
+#include "memory.h"
+#include "canvas.h"
+#include "resources.h"
+#include "text.h"
+#include "plots/plot.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+
+
+namespace SimplePlot {
+	MemoryUsage& MemoryUsage::operator+=(MemoryUsage const& other) {
+		data += other.data;
+		caches += other.caches;
+		bitmaps += other.bitmaps;
+		scratch += other.scratch;
+		gdiObjects += other.gdiObjects;
+		return *this;
+	}
+
+	namespace Memory {
+		namespace {
+			std::mutex ledgerMutex;
+			std::map<std::pair<OWNER, int>, MemoryUsage> ledger;
+			std::atomic<bool> debugging = false;
+			std::vector<LeakReport> leakReports;// Guarded by ledgerMutex
+
+			bool isEmpty(MemoryUsage const& usage) {
+				return usage.total() == 0 && usage.gdiObjects == 0;
+			}
+		}
+
+		void charge(OWNER owner, int id, MEMORY_CATEGORY category, long long bytes) {
+			std::lock_guard<std::mutex> guard(ledgerMutex);
+			MemoryUsage& usage = ledger[{ owner, id }];
+			switch (category) {
+			case MEMORY_CATEGORY::DATA:
+				usage.data += bytes;
+				break;
+			case MEMORY_CATEGORY::CACHES:
+				usage.caches += bytes;
+				break;
+			case MEMORY_CATEGORY::BITMAPS:
+				usage.bitmaps += bytes;
+				break;
+			case MEMORY_CATEGORY::SCRATCH:
+				usage.scratch += bytes;
+				break;
+			}
+		}
+
+		void chargeGDI(OWNER owner, int id, int objects) {
+			std::lock_guard<std::mutex> guard(ledgerMutex);
+			ledger[{ owner, id }].gdiObjects += objects;
+		}
+
+		MemoryUsage getCharged(OWNER owner, int id) {
+			std::lock_guard<std::mutex> guard(ledgerMutex);
+			auto it = ledger.find({ owner, id });
+			return it == ledger.end() ? MemoryUsage() : it->second;
+		}
+
+		void close(OWNER owner, int id) {
+			std::lock_guard<std::mutex> guard(ledgerMutex);
+			auto it = ledger.find({ owner, id });
+			if (it == ledger.end()) { return; }
+			if (debugging.load(std::memory_order_relaxed) && !isEmpty(it->second)) {
+				LeakReport report;
+				report.canvas = owner == CANVAS_OWNER;
+				report.id = id;
+				report.usage = it->second;
+				leakReports.push_back(report);
+			}
+			ledger.erase(it);
+		}
+	}
+
+	MemoryStats getMemoryStats() {
+		MemoryStats stats;
+		stats.plots = getPlotMemoryUsage();
+		stats.canvases = getCanvasMemoryUsage();
+		stats.shared.caches = Text::getTextCacheStats().bytes;
+		stats.shared.gdiObjects = Resources::getResourceStats().live;
+
+		stats.total = stats.shared;
+		for (PlotMemory const& plot : stats.plots) {
+			stats.total += plot.usage;
+		}
+		for (CanvasMemory const& canvas : stats.canvases) {
+			stats.total += canvas.usage;
+		}
+		return stats;
+	}
+
+	void setMemoryDebug(bool enabled) {
+		Memory::debugging.store(enabled, std::memory_order_relaxed);
+	}
+
+	std::vector<LeakReport> takeLeakReports() {
+		std::lock_guard<std::mutex> guard(Memory::ledgerMutex);
+		std::vector<LeakReport> reports;
+		reports.swap(Memory::leakReports);
+		return reports;
+	}
+}
\ No newline at end of file
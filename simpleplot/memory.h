@@ -0,0 +1,65 @@
+#pragma once
+#include <vector>
+
+#include "standard.h"
+
+
+namespace SimplePlot {
+	// Bytes by category, and GDI objects by count.
+	struct MemoryUsage {
+		long long data = 0;// Copies of data the library owns: isolated plots, custom bins
+		long long caches = 0;// Log caches, sketches, limits, draw lists, text masks
+		long long bitmaps = 0;// Window back buffers and frames queued for recording
+		long long scratch = 0;// Working space kept between frames, such as the rasterizer's bins
+		int gdiObjects = 0;
+
+		long long total() const { return data + caches + bitmaps + scratch; }
+		MemoryUsage& operator+=(MemoryUsage const& other);
+	};
+
+	struct PlotMemory {
+		PLOT_ID plot = SP_NULL_PLOT;
+		MemoryUsage usage;
+	};
+
+	struct CanvasMemory {
+		CANVAS_ID canvas = SP_NULL_CANVAS;
+		MemoryUsage usage;
+	};
+
+	struct MemoryStats {
+		std::vector<CanvasMemory> canvases;
+		std::vector<PlotMemory> plots;
+		MemoryUsage shared;// The text cache, and every GDI object in the shared resource cache
+		MemoryUsage total;
+	};
+
+	// What a deleted plot or canvas still had charged to it once it was destroyed.
+	struct LeakReport {
+		bool canvas = false;
+		int id = -1;
+		MemoryUsage usage;
+	};
+
+	MemoryStats getMemoryStats();
+
+	// In debug mode, deletePlot and deleteCanvas check that everything charged to the object was given back,
+	// and keep a report of anything that wasn't. Off by default.
+	void setMemoryDebug(bool enabled);
+	std::vector<LeakReport> takeLeakReports();// Returns the reports so far and clears them
+
+	namespace Memory {
+		enum OWNER {
+			PLOT_OWNER,
+			CANVAS_OWNER,
+		};
+
+		// A ledger of memory that the library allocates by hand for a plot or canvas. Whatever allocates
+		// charges the owner and whatever frees gives it back, so a missing free shows up as a balance that
+		// outlives the owner. Memory held in containers is measured directly instead.
+		void charge(OWNER owner, int id, MEMORY_CATEGORY category, long long bytes);// Negative to give back
+		void chargeGDI(OWNER owner, int id, int objects);
+		MemoryUsage getCharged(OWNER owner, int id);
+		void close(OWNER owner, int id);// Call once the owner has been destroyed
+	}
+}
\ No newline at end of file
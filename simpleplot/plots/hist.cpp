@@ -2,8 +2,10 @@
 #pragma warning(disable:4244)
 
 #include "../stats.h"
+#include <cmath>
 #include <thread>
 #include <mutex>
+#include <vector>
 
 namespace SimplePlot::Hist {
 	template<typename Y>
@@ -18,75 +20,60 @@ namespace SimplePlot::Hist {
 	template<typename Y>
 	Hist<Y>::Hist(Y* data, int sizeData, Y* leftBins_, int numBins, int style, std::wstring name, bool normal)
 		: Plot(PLOT_TYPE::HISTOGRAM, AXIS_TYPE::CART_2D, style, name), data(data), sizeData(sizeData), numBins(numBins), normal(normal) {
-		if (numBins > 2) {
+		if (numBins < 2) {
 			throw std::invalid_argument("Num Bins must be >= 2");
 		}
 		leftBins = new Y[numBins];
 		memcpy(leftBins, leftBins_, numBins * sizeof(Y));
+		Memory::charge(Memory::PLOT_OWNER, id, MEMORY_CATEGORY::DATA, numBins * sizeof(Y));
 	}
 
 	template<typename Y>
 	Hist<Y>::~Hist() {
-		if (leftBins) delete[] leftBins;
+		if (leftBins) {
+			delete[] leftBins;
+			Memory::charge(Memory::PLOT_OWNER, id, MEMORY_CATEGORY::DATA, -(long long)(numBins * sizeof(Y)));
+		}
 	}
 
 
 	template<typename Y>
-	void Hist<Y>::getAxisLimits(float* axisLimits) const {
+	void Hist<Y>::getAxisLimits(double* axisLimits) const {
 		// axisLimits: {minX, maxX, minY, maxY}
-		axisLimits[0] = (float)SimplePlot::Stats::minValue(data, sizeData);
-		axisLimits[1] = (float)SimplePlot::Stats::maxValue(data, sizeData);
+		axisLimits[0] = relative(SimplePlot::Stats::minValue(data, sizeData), 0);
+		axisLimits[1] = relative(SimplePlot::Stats::maxValue(data, sizeData), 0);
 		axisLimits[2] = 0;
 
-		int* binCounts = new int[numBins];
-		for (int i = 0; i < numBins; i++) {
-			binCounts[i] = 0;
-		}
-		if (leftBins) {
-			for (int i = 0; i < sizeData; i++) {
-				binCounts[SimplePlot::Stats::binFindLeft<Y>(leftBins, numBins, data[i])]++;
-			}
-		}
-		else {
-			for (int i = 0; i < sizeData; i++) {
-				int index = int((data[i] - minBin) / (maxBin - minBin) * numBins * (numBins / (numBins + 1.0f)));
-				// The final term is to make the second bound inclusive
+		std::vector<int> binCounts(numBins);
+		countBins(binCounts.data());
+		axisLimits[3] = SimplePlot::Stats::maxValue(binCounts.data(), numBins);
+	}
+
+	template<typename Y>
+	int Hist<Y>::getDataSize() const {
+		return sizeData;
+	}
 
-				if (index < 0 || index >= numBins) { continue; }
-				binCounts[index]++;
-			}
+	template<typename Y>
+	void Hist<Y>::sketchData(int axisNum, int begin, int end, Sketch::KllSketch& sketch) const {
+		// Only x has samples; the counts on y are derived from all of them at once. Histograms are never on a
+		// log axis.
+		if (axisNum != 0) { return; }
+		for (int i = begin; i < end; i++) {
+			double position = relative(data[i], 0);
+			if (std::isfinite(position)) { sketch.update(position); }
 		}
-		axisLimits[3] = SimplePlot::Stats::maxValue(binCounts, numBins);
 	}
 
 	template<typename Y>
-	void Hist<Y>::draw(HDC hdc, float const* axisLimits, POINT const* drawSpace) const {
+	void Hist<Y>::draw(HDC hdc, double const* axisLimits, POINT const* drawSpace) const {
 		// axisLimits: {minX, maxX, minY, maxY}
 		// axisPoints: {origin, endX, endY, farCorner}
 
 		SelectObject(hdc, style.forePen);
 
-		int* binCounts = new int[numBins];
-		for (int i = 0; i < numBins; i++) {
-			binCounts[i] = 0;
-		}
-		if (leftBins) {
-			for (int i = 0; i < sizeData; i++) {
-				binCounts[SimplePlot::Stats::binFindLeft<Y>(leftBins, numBins, data[i])]++;
-			}
-		}
-		else {
-			for (int i = 0; i < sizeData; i++) {
-				int index = int((data[i] - minBin) / (maxBin - minBin) * numBins * (numBins / (numBins + 1.0f)));
-				// The final term is to make the second bound inclusive
-
-				if (index < 0 || index >= numBins) { continue; }
-				binCounts[index]++;
-			}
-		}
-
-		const int maxCount = SimplePlot::Stats::maxValue(binCounts, numBins);
-		const int minCount = 0;
+		std::vector<int> binCounts(numBins);
+		countBins(binCounts.data());
 
 		const POINT origin = drawSpace[0];
 		const POINT endX = drawSpace[1];
@@ -94,13 +81,12 @@ namespace SimplePlot::Hist {
 		const POINT farCorner = drawSpace[3];
 
 
-		// Draw data
+		// Draw data. Bars share the axis out evenly; their heights follow the y axis.
 		MoveToEx(hdc, origin.x, origin.y, NULL);
-		float pixelsPerBin = float(endX.x - origin.x) / numBins;
+		Transform::AffineMap mapBin(0, numBins, origin.x, endX.x);
+		Transform::AffineMap mapY(axisLimits[2], axisLimits[3], origin.y, endY.y);
 		for (int binNum = 0; binNum < numBins; binNum++) {
-			LONG height = float(binCounts[binNum] - minCount) / (maxCount - minCount) * (origin.y - endY.y);
-			RECT rect = { LONG(origin.x + pixelsPerBin * binNum), origin.y - height,
-				LONG(origin.x + pixelsPerBin * (binNum + 1)), origin.y };
+			RECT rect = { LONG(mapBin(binNum)), LONG(mapY(binCounts[binNum])), LONG(mapBin(binNum + 1)), origin.y };
 			FillRect(hdc, &rect, style.foreBrush);
 			LineTo(hdc, rect.left, rect.top);
 			LineTo(hdc, rect.right, rect.top);
@@ -108,6 +94,53 @@ namespace SimplePlot::Hist {
 		LineTo(hdc, endX.x, endX.y);
 	}
 
+	template<typename Y>
+	void Hist<Y>::record(Render::DrawList& list, double const* axisLimits, POINT const* drawSpace) const {
+		std::vector<int> binCounts(numBins);
+		countBins(binCounts.data());
+
+		const POINT origin = drawSpace[0];
+		const POINT endX = drawSpace[1];
+		const POINT endY = drawSpace[2];
+
+		// Bars first, then the outline on top of them, as in draw.
+		Transform::AffineMap mapBin(0, numBins, origin.x, endX.x);
+		Transform::AffineMap mapY(axisLimits[2], axisLimits[3], origin.y, endY.y);
+		Render::Pixel fill = Render::pixelFromColorRef(style.foreBrushColor);
+		for (int binNum = 0; binNum < numBins; binNum++) {
+			list.fillRect(float(LONG(mapBin(binNum))), float(LONG(mapY(binCounts[binNum]))),
+				float(LONG(mapBin(binNum + 1))), float(origin.y), fill);
+		}
+
+		list.beginPath(Render::pixelFromColorRef(style.forePenColor), style.foreWidth);
+		list.moveTo((float)origin.x, (float)origin.y);
+		for (int binNum = 0; binNum < numBins; binNum++) {
+			float top = float(LONG(mapY(binCounts[binNum])));
+			list.lineTo(float(LONG(mapBin(binNum))), top);
+			list.lineTo(float(LONG(mapBin(binNum + 1))), top);
+		}
+		list.lineTo((float)endX.x, (float)endX.y);
+		list.endPath();
+	}
+
+	template<typename Y>
+	void Hist<Y>::countBins(int* binCounts) const {
+		for (int i = 0; i < numBins; i++) {
+			binCounts[i] = 0;
+		}
+		if (leftBins) {
+			SimplePlot::Stats::countCustomBins<Y>(data, sizeData, leftBins, numBins, binCounts);
+		}
+		else {
+			SimplePlot::Stats::countUniformBins<Y>(data, sizeData, minBin, maxBin, numBins, binCounts);
+		}
+	}
+
+	template<typename Y>
+	long long Hist<Y>::getDataBytes() const {
+		return (long long)sizeData * sizeof(Y);
+	}
+
 	template<typename Y>
 	void Hist<Y>::isolateData() {
 		Y* newData = new Y[sizeData];
@@ -14,10 +14,15 @@ namespace SimplePlot::Hist {
 
 
 	private:
-		void getAxisLimits(float* axisLimits) const override;
-		void draw(HDC hdc, float const* axisLimits, POINT const* drawSpace) const override;
+		void getAxisLimits(double* axisLimits) const override;
+		void draw(HDC hdc, double const* axisLimits, POINT const* drawSpace) const override;
+		void record(Render::DrawList& list, double const* axisLimits, POINT const* drawSpace) const override;
 		void isolateData() override;
 		void deleteData() override;
+		int getDataSize() const override;
+		void sketchData(int axisNum, int begin, int end, Sketch::KllSketch& sketch) const override;
+		long long getDataBytes() const override;
+		void countBins(int* binCounts) const;
 
 		Y* data;
 		int sizeData;
@@ -2,6 +2,7 @@
 #pragma warning(disable:4244)
 
 #include "../stats.h"
+#include <cmath>
 #include <thread>
 #include <mutex>
 
@@ -17,61 +18,103 @@ namespace SimplePlot::Line {
 	}
 
 	template<typename X, typename Y>
-	void Line<X, Y>::getAxisLimits(float* axisLimits) const {
-		axisLimits[0] = (float)SimplePlot::Stats::minValue<X>(xData, sizeData);
-		axisLimits[1] = (float)SimplePlot::Stats::maxValue<X>(xData, sizeData);
-		axisLimits[2] = (float)SimplePlot::Stats::minValue<Y>(yData, sizeData);
-		axisLimits[3] = (float)SimplePlot::Stats::maxValue<Y>(yData, sizeData);
+	void Line<X, Y>::getAxisLimits(double* axisLimits) const {
+		if (logAxes[0]) {
+			xLog.get<X>(xData, sizeData, dataVersion);
+			axisLimits[0] = xLog.minValue();
+			axisLimits[1] = xLog.maxValue();
+		}
+		else {
+			axisLimits[0] = relative(SimplePlot::Stats::minValue<X>(xData, sizeData), 0);
+			axisLimits[1] = relative(SimplePlot::Stats::maxValue<X>(xData, sizeData), 0);
+		}
+		if (logAxes[1]) {
+			yLog.get<Y>(yData, sizeData, dataVersion);
+			axisLimits[2] = yLog.minValue();
+			axisLimits[3] = yLog.maxValue();
+		}
+		else {
+			axisLimits[2] = relative(SimplePlot::Stats::minValue<Y>(yData, sizeData), 1);
+			axisLimits[3] = relative(SimplePlot::Stats::maxValue<Y>(yData, sizeData), 1);
+		}
+	}
+
+
+	template<typename X, typename Y>
+	int Line<X, Y>::getDataSize() const {
+		return sizeData;
 	}
 
+	template<typename X, typename Y>
+	bool Line<X, Y>::resizeData(int newSize) {
+		sizeData = newSize;
+		return true;
+	}
+
+	template<typename X, typename Y>
+	bool Line<X, Y>::getRangeLimits(double* axisLimits, int begin, int end) const {
+		if (logAxes[0] || logAxes[1]) { return false; }// The log caches are redone whole anyway
+		axisLimits[0] = relative(SimplePlot::Stats::minValue<X>(xData + begin, end - begin), 0);
+		axisLimits[1] = relative(SimplePlot::Stats::maxValue<X>(xData + begin, end - begin), 0);
+		axisLimits[2] = relative(SimplePlot::Stats::minValue<Y>(yData + begin, end - begin), 1);
+		axisLimits[3] = relative(SimplePlot::Stats::maxValue<Y>(yData + begin, end - begin), 1);
+		return true;
+	}
 
 	template<typename X, typename Y>
-	void Line<X, Y>::draw(HDC hdc, float const* axisLimits, POINT const* drawSpace) const {
+	void Line<X, Y>::sketchData(int axisNum, int begin, int end, Sketch::KllSketch& sketch) const {
+		if (axisNum == 0) {
+			sketchAxis<X>(xData, sizeData, begin, end, 0, xLog, sketch);
+		}
+		else if (axisNum == 1) {
+			sketchAxis<Y>(yData, sizeData, begin, end, 1, yLog, sketch);
+		}
+	}
+
+
+	template<typename X, typename Y>
+	template<typename Add>
+	void Line<X, Y>::trace(double const* axisLimits, POINT const* drawSpace, Add&& add) const {
 		// axisLimits: {minX, maxX, minY, maxY}
 		// axisPoints: {origin, endX, endY, farCorner}
-		SelectObject(hdc, style.forePen);
-
-		LONG x = drawSpace[0].x + ((float)xData[0] - axisLimits[0]) / (axisLimits[1] - axisLimits[0]) * (drawSpace[1].x - drawSpace[0].x);
-		LONG y = drawSpace[0].y + ((float)yData[0] - axisLimits[2]) / (axisLimits[3] - axisLimits[2]) * (drawSpace[2].y - drawSpace[0].y);
-		MoveToEx(hdc, x, y, NULL);
-		for (int i = 1; i < sizeData; i++) {
-			LONG x = drawSpace[0].x + ((float)xData[i] - axisLimits[0]) / (axisLimits[1] - axisLimits[0]) * (drawSpace[1].x - drawSpace[0].x);
-			LONG y = drawSpace[0].y + ((float)yData[i] - axisLimits[2]) / (axisLimits[3] - axisLimits[2]) * (drawSpace[2].y - drawSpace[0].y);
-			switch (style.foreStyle) {
-			case SP_SOLID:
-				LineTo(hdc, x, y);
-				break;
-			case SP_DASH:
-				if ((x / 10) % 2 == 0) { LineTo(hdc, x, y); }
-				else { MoveToEx(hdc, x, y, NULL); }
-				break;
-			case SP_DOT:
-				if ((x / 2) % 2 == 0) { LineTo(hdc, x, y); }
-				else { MoveToEx(hdc, x, y, NULL); }
-				break;
-			case SP_DASHDOT:
-				if ((x / 10) % 2 == 0) { LineTo(hdc, x, y); }
-				else {
-					if ((x / 10) == 4 || (x / 10) == 5) { LineTo(hdc, x, y); }
-					else { MoveToEx(hdc, x, y, NULL); }
-				}
-				break;
-			case SP_DASHDOTDOT:
-				if ((x / 10) % 3 == 0) { LineTo(hdc, x, y); }
-				else {
-					if ((x / 10) % 3 == 1 && ((x / 10) == 6 || (x / 10) == 7)) { LineTo(hdc, x, y); }
-					else if ((x / 10) % 3 == 2 && ((x / 10) == 2 || (x / 10) == 3)) { LineTo(hdc, x, y); }
-					else { MoveToEx(hdc, x, y, NULL); }
-				}
-				break;
-			default:
-				break;
-			}
+		// On a log axis the cached log10 of the data stands in for the data. Otherwise positions are taken
+		// relative to the axis origin in double precision, so nanosecond timestamps stay distinct. Values that
+		// aren't positive on a log axis map to non-finite positions, which break the line.
+		float const* xs = logAxes[0] ? xLog.get<X>(xData, sizeData, dataVersion) : nullptr;
+		float const* ys = logAxes[1] ? yLog.get<Y>(yData, sizeData, dataVersion) : nullptr;
+		Transform::AffineMap mapX(axisLimits[0], axisLimits[1], drawSpace[0].x, drawSpace[1].x);
+		Transform::AffineMap mapY(axisLimits[2], axisLimits[3], drawSpace[0].y, drawSpace[2].y);
+		for (int i = 0; i < sizeData; i++) {
+			double fx = xs ? xs[i] : relative(xData[i], 0);
+			double fy = ys ? ys[i] : relative(yData[i], 1);
+			float x, y;
+			Transform::mapPoint(mapX, mapY, fx, fy, x, y);
+			add(x, y);
 		}
 	}
 
+	template<typename X, typename Y>
+	void Line<X, Y>::draw(HDC hdc, double const* axisLimits, POINT const* drawSpace) const {
+		drawPath(hdc, sizeData, drawSpace, [&](auto&& add) { trace(axisLimits, drawSpace, add); });
+	}
+
+	template<typename X, typename Y>
+	void Line<X, Y>::record(Render::DrawList& list, double const* axisLimits, POINT const* drawSpace) const {
+		recordPath(list, sizeData, drawSpace, [&](auto&& add) { trace(axisLimits, drawSpace, add); });
+	}
 
 
+
+	template<typename X, typename Y>
+	long long Line<X, Y>::getDataBytes() const {
+		return (long long)sizeData * (sizeof(X) + sizeof(Y));
+	}
+
+	template<typename X, typename Y>
+	long long Line<X, Y>::getCacheBytes() const {
+		return Plot::getCacheBytes() + xLog.bytes() + yLog.bytes();
+	}
+
 	template<typename X, typename Y>
 	void Line<X, Y>::isolateData() {
 		X* newX = new X[sizeData];
@@ -99,6 +142,9 @@ namespace SimplePlot::Line {
 	template class Line<float, int>;
 	template class Line<double, int>;
 	template class Line<int, int>;
+	template class Line<long long, float>;
+	template class Line<long long, double>;
+	template class Line<long long, int>;
 }
 
 
@@ -121,4 +167,7 @@ namespace SimplePlot {
 	template PLOT_ID makeLine<float, int>(float* x, int* y, int sizeData, int style, std::wstring name);
 	template PLOT_ID makeLine<double, int>(double* x, int* y, int sizeData, int style, std::wstring name);
 	template PLOT_ID makeLine<int, int>(int* x, int* y, int sizeData, int style, std::wstring name);
+	template PLOT_ID makeLine<long long, float>(long long* x, float* y, int sizeData, int style, std::wstring name);
+	template PLOT_ID makeLine<long long, double>(long long* x, double* y, int sizeData, int style, std::wstring name);
+	template PLOT_ID makeLine<long long, int>(long long* x, int* y, int sizeData, int style, std::wstring name);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include "plot.h"
 #include "../axis.h"
+#include "../transform.h"
 
 
 namespace SimplePlot::Line {
@@ -12,14 +13,24 @@ namespace SimplePlot::Line {
 
 
 	private:
-		void getAxisLimits(float* axisLimits) const override;
-		void draw(HDC hdc, float const* axisLimits, POINT const* drawSpace) const override;
+		void getAxisLimits(double* axisLimits) const override;
+		void draw(HDC hdc, double const* axisLimits, POINT const* drawSpace) const override;
+		void record(Render::DrawList& list, double const* axisLimits, POINT const* drawSpace) const override;
 		void isolateData() override;
 		void deleteData() override;
+		int getDataSize() const override;
+		bool resizeData(int newSize) override;
+		bool getRangeLimits(double* axisLimits, int begin, int end) const override;
+		void sketchData(int axisNum, int begin, int end, Sketch::KllSketch& sketch) const override;
+		long long getDataBytes() const override;
+		long long getCacheBytes() const override;
+		template<typename Add>
+		void trace(double const* axisLimits, POINT const* drawSpace, Add&& add) const;
 
 		X* xData;
 		Y* yData;
 		int sizeData;
+		mutable Transform::LogCache xLog, yLog;
 	};
 }
 
@@ -1,9 +1,17 @@
 #pragma comment(lib, "Shcore.lib")
+#pragma comment(lib, "Msimg32.lib")
 #include "plot.h"
 #include "../canvas.h"
+#include "../locks.h"
+#include "../render/pool.h"
+#include "../trace.h"
 
+#include <chrono>
+#include <cmath>
+#include <deque>
 #include <map>
 #include <mutex>
+#include <thread>
 
 
 namespace SimplePlot {
@@ -12,14 +20,22 @@ namespace SimplePlot {
 		std::map<PLOT_ID, PLOT_TYPE> plotTypeMap;
 		std::map<PLOT_ID, std::mutex> plotMutexMap;
 		std::mutex mapMutex;
+		Locks::Site plotGuardMapSite("PlotGuard mapMutex");
+		Locks::Site plotGuardPlotSite("PlotGuard plot mutex");
+		Locks::Site plotRegistrySite("plot registry mapMutex");// Creating, deleting and listing plots
+		Locks::Site listingPlotSite("plot listing plot mutex");
+		Locks::Site recordingPlotSite("recordPlot plot mutex");
+		Locks::Site deletingPlotSite("deletePlot plot mutex");
+
 		class PlotGuard {
 		public:
-			PlotGuard(PLOT_ID id) : generalGuard(Maps::mapMutex), specificGuard(Maps::plotMutexMap[id]) {}
+			PlotGuard(PLOT_ID id) : generalGuard(Maps::mapMutex, plotGuardMapSite), specificGuard(Maps::plotMutexMap[id], plotGuardPlotSite) {}
 
 		private:
-			std::lock_guard<std::mutex> generalGuard;
-			std::lock_guard<std::mutex> specificGuard;
+			Locks::LockGuard generalGuard;
+			Locks::LockGuard specificGuard;
 		};
+
 	}
 
 	namespace Plot {
@@ -29,34 +45,131 @@ namespace SimplePlot {
 			maxID++;
 
 			numAxes = Axes::getNumAxes(axisType);
-			setAxisLimits = new float[numAxes * 2];
+			setAxisLimits = new double[numAxes * 2];
+			extents = new double[numAxes * 2];
 			isSetAxisLimits = new bool[numAxes * 2];
 			for (int i = 0; i < numAxes * 2; i++) {
 				isSetAxisLimits[i] = 0;
 			}
+			logAxes = new bool[numAxes];
+			axisOrigins = new long long[numAxes];
+			for (int i = 0; i < numAxes; i++) {
+				logAxes[i] = false;
+				axisOrigins[i] = 0;
+			}
+			Memory::charge(Memory::PLOT_OWNER, id, MEMORY_CATEGORY::CACHES, limitsBytes());
+		}
+
+		Plot::~Plot() {
+			delete[] setAxisLimits;
+			delete[] extents;
+			delete[] isSetAxisLimits;
+			delete[] logAxes;
+			delete[] axisOrigins;
+			delete[] sketches;
+			Memory::charge(Memory::PLOT_OWNER, id, MEMORY_CATEGORY::CACHES, -limitsBytes());
+		}
+
+		long long Plot::limitsBytes() const {
+			return (long long)numAxes * (2 * sizeof(double) + 2 * sizeof(double) + 2 * sizeof(bool) + sizeof(bool) + sizeof(long long));
+		}
+
+		long long Plot::getCacheBytes() const {
+			// The limits arrays are in the ledger; this is what is measured.
+			long long total = 0;
+			if (sketches) {
+				for (int i = 0; i < numAxes; i++) {
+					total += (long long)sizeof(AxisSketch) + sketches[i].sketch.bytes();
+				}
+			}
+			return total;
 		}
 
-		void Plot::getGeneralAxisLimits(float* axisLimits, bool set) const {
-			float* tempAxisLimits = new float[numAxes * 2];
-			getAxisLimits(tempAxisLimits);
+		void Plot::getGeneralAxisLimits(double* axisLimits, bool set, bool rescan) {
+			// The data is only looked at again after updatePlotData or appendPlotData, or when the axes are
+			// measured differently. After an append only the new values are. Data the caller can still edit in
+			// place is looked at in full whenever rescan asks, since nothing says when it changes.
+			bool edited = rescan && !isolated;
+			if (!extentsValid || extentsVersion != dataVersion || edited) {
+				Trace::Span span("extents", "plot", id);
+				int size = getDataSize();
+				bool extended = false;
+				if (extentsValid && !edited && extentsVersion >= appendBase && size >= extentsSize) {
+					double* added = new double[numAxes * 2];
+					extended = size == extentsSize || getRangeLimits(added, extentsSize, size);
+					if (extended && size > extentsSize) {
+						for (int i = 0; i < numAxes * 2; i += 2) {
+							extents[i] = min(extents[i], added[i]);
+							extents[i + 1] = max(extents[i + 1], added[i + 1]);
+						}
+					}
+					delete[] added;
+				}
+				if (!extended) {
+					getAxisLimits(extents);
+				}
+				extentsVersion = dataVersion;
+				extentsSize = size;
+				extentsValid = true;
+			}
 
 			for (int i = 0; i < numAxes * 2; i++) {
+				double limit = extents[i];
 				if (isSetAxisLimits[i] != 0) {
-					tempAxisLimits[i] = setAxisLimits[i];
+					limit = logAxes[i / 2] ? log10(setAxisLimits[i]) : setAxisLimits[i] - axisOrigins[i / 2];
 				}
 				if (set) {
-					axisLimits[i] = tempAxisLimits[i];
+					axisLimits[i] = limit;
 				}
 				else {
 					if (i % 2 == 0) {
-						axisLimits[i] = min(tempAxisLimits[i], axisLimits[i]);
+						axisLimits[i] = min(limit, axisLimits[i]);
 					}
 					else {
-						axisLimits[i] = max(tempAxisLimits[i], axisLimits[i]);
+						axisLimits[i] = max(limit, axisLimits[i]);
 					}
 				}
 			}
-			delete[] tempAxisLimits;
+		}
+
+		void Plot::mergeSketch(int axisNum, Sketch::KllSketch& into) {
+			if (axisNum < 0 || axisNum >= numAxes) { return; }
+			if (!sketches) {
+				sketches = new AxisSketch[numAxes];
+			}
+			AxisSketch& axis = sketches[axisNum];
+			if (!axis.valid || axis.version != dataVersion) {
+				int size = getDataSize();
+				if (!axis.valid || axis.version < appendBase || size < axis.size) {
+					axis.sketch.clear();
+					axis.size = 0;
+				}
+				sketchData(axisNum, axis.size, size, axis.sketch);
+				axis.size = size;
+				axis.version = dataVersion;
+				axis.valid = true;
+			}
+			into.merge(axis.sketch);
+		}
+
+		void Plot::appendData(int newSize) {
+			if (!isolated && newSize >= getDataSize() && resizeData(newSize)) {
+				dataVersion++;
+			}
+			else {
+				dataVersion++;
+				appendBase = dataVersion;
+			}
+		}
+
+		void Plot::invalidateExtents() {
+			// Positions along an axis have changed meaning, so everything measured in them is stale.
+			extentsValid = false;
+			if (sketches) {
+				for (int i = 0; i < numAxes; i++) {
+					sketches[i].valid = false;
+				}
+			}
 		}
 
 		void Plot::drawLegend(HDC hdc, RECT legendRect) {
@@ -66,27 +179,111 @@ namespace SimplePlot {
 			legendRect.left += 20;
 			DrawText(hdc, name.c_str(), (int)name.size(), &legendRect, NULL);
 		}
+
+		void Plot::recordLegend(Render::DrawList& list, RECT legendRect) const {
+			list.beginPath(Render::pixelFromColorRef(style.forePenColor), style.foreWidth);
+			list.moveTo((float)legendRect.left, (float)legendRect.top + 15);
+			list.lineTo((float)legendRect.left + 15, (float)legendRect.top + 15);
+			list.endPath();
+		}
+
+		bool Plot::penDown(LONG x) const {
+			// Whether the pen touches the canvas at pixel column x for the plot's dash style.
+			switch (style.foreStyle) {
+			case SP_SOLID:
+				return true;
+			case SP_DASH:
+				return (x / 10) % 2 == 0;
+			case SP_DOT:
+				return (x / 2) % 2 == 0;
+			case SP_DASHDOT:
+				return (x / 10) % 2 == 0 || (x / 10) == 4 || (x / 10) == 5;
+			case SP_DASHDOTDOT:
+				return (x / 10) % 3 == 0 || ((x / 10) % 3 == 1 && ((x / 10) == 6 || (x / 10) == 7))
+					|| ((x / 10) % 3 == 2 && ((x / 10) == 2 || (x / 10) == 3));
+			default:
+				return false;
+			}
+		}
+
+		void Plot::drawImage(HDC hdc, Render::Image const& image) const {
+			if (image.width == 0) { return; }
+
+			BITMAPINFO bmi = {};
+			bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+			bmi.bmiHeader.biWidth = image.width;
+			bmi.bmiHeader.biHeight = -image.height;// Top-down
+			bmi.bmiHeader.biPlanes = 1;
+			bmi.bmiHeader.biBitCount = 32;
+			bmi.bmiHeader.biCompression = BI_RGB;
+			void* bits = nullptr;
+			HBITMAP bitmap = CreateDIBSection(hdc, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+			if (!bitmap) { return; }
+
+			// AlphaBlend wants premultiplied alpha.
+			Render::Pixel* dst = (Render::Pixel*)bits;
+			for (size_t i = 0; i < image.pixels.size(); i++) {
+				Render::Pixel p = image.pixels[i];
+				unsigned int a = p >> 24;
+				dst[i] = (a << 24) | ((((p >> 16) & 0xff) * a / 255) << 16) | ((((p >> 8) & 0xff) * a / 255) << 8) | ((p & 0xff) * a / 255);
+			}
+
+			HDC hdcImage = CreateCompatibleDC(hdc);
+			HBITMAP oldBitmap = (HBITMAP)SelectObject(hdcImage, bitmap);
+			BLENDFUNCTION blend = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
+			AlphaBlend(hdc, image.left, image.top, image.width, image.height, hdcImage, 0, 0, image.width, image.height, blend);
+			SelectObject(hdcImage, oldBitmap);
+			DeleteDC(hdcImage);
+			DeleteObject(bitmap);
+		}
 	}
 
 	void deletePlot(PLOT_ID id) {
-		Maps::mapMutex.lock();/// Possibly not necessary.
-		Plot::Plot* plot = Maps::plotPointerMap[id];
-		Maps::mapMutex.unlock();
+		Plot::Plot* plot;
+		{
+			Locks::LockGuard guard(Maps::mapMutex, Maps::plotRegistrySite);/// Possibly not necessary.
+			plot = Maps::plotPointerMap[id];
+		}
 
 		if (plot->canvas != SP_NULL_CANVAS) {
 			removePlotFromCanvas(plot->canvas, id);
 		}
 
-		std::lock_guard<std::mutex> guard(Maps::mapMutex);
+		Locks::LockGuard guard(Maps::mapMutex, Maps::plotRegistrySite);
+		{
+			// recordPlots holds plots' own mutexes without mapMutex. Nothing else can take this one while
+			// mapMutex is held, so once it's free it can go.
+			Locks::LockGuard drain(Maps::plotMutexMap[id], Maps::deletingPlotSite);
+		}
 		Maps::plotPointerMap.erase(id);
 		Maps::plotMutexMap.erase(id);
 		Maps::plotTypeMap.erase(id);
 
+		if (plot->isolated) {
+			// The copy belongs to the plot, not to whoever made it.
+			plot->deleteData();
+			Memory::charge(Memory::PLOT_OWNER, id, MEMORY_CATEGORY::DATA, -plot->isolatedBytes);
+		}
 		delete plot;
+		Memory::close(Memory::PLOT_OWNER, id);
+	}
+
+	std::vector<PlotMemory> getPlotMemoryUsage() {
+		Locks::LockGuard generalGuard(Maps::mapMutex, Maps::plotRegistrySite);
+		std::vector<PlotMemory> usage;
+		for (auto const& entry : Maps::plotPointerMap) {
+			Locks::LockGuard specificGuard(Maps::plotMutexMap[entry.first], Maps::listingPlotSite);
+			PlotMemory plot;
+			plot.plot = entry.first;
+			plot.usage = Memory::getCharged(Memory::PLOT_OWNER, entry.first);
+			plot.usage.caches += entry.second->getCacheBytes();
+			usage.push_back(plot);
+		}
+		return usage;
 	}
 
 	void registerPlot(PLOT_ID id, Plot::Plot* plt, PLOT_TYPE plotType) {
-		std::lock_guard<std::mutex> g(Maps::mapMutex);
+		Locks::LockGuard g(Maps::mapMutex, Maps::plotRegistrySite);
 		Maps::plotPointerMap[id] = plt;
 		Maps::plotTypeMap[id] = plotType;
 		Maps::plotMutexMap[id];
@@ -102,24 +299,34 @@ namespace SimplePlot {
 		return Maps::plotPointerMap.at(id)->plotType;
 	}
 
-	void getPlotAxisLimits(PLOT_ID id, float* axisLimits, bool set) {
+	void getPlotAxisLimits(PLOT_ID id, double* axisLimits, bool set, bool rescan) {
 		Maps::PlotGuard guard(id);
-		Maps::plotPointerMap.at(id)->getGeneralAxisLimits(axisLimits, set);
+		Maps::plotPointerMap.at(id)->getGeneralAxisLimits(axisLimits, set, rescan);
 	}
 
 	void isolatePlotData(PLOT_ID id) {
 		Maps::PlotGuard guard(id);
-		Maps::plotPointerMap.at(id)->isolateData();
+		Plot::Plot* plot = Maps::plotPointerMap.at(id);
+		plot->isolateData();
+		plot->isolated = true;
+		plot->isolatedBytes = plot->getDataBytes();
+		Memory::charge(Memory::PLOT_OWNER, id, MEMORY_CATEGORY::DATA, plot->isolatedBytes);
 	}
 
 	void deletePlotData(PLOT_ID id) {
 		Maps::PlotGuard guard(id);
-		Maps::plotPointerMap.at(id)->deleteData();
+		Plot::Plot* plot = Maps::plotPointerMap.at(id);
+		plot->deleteData();
+		plot->isolated = false;
+		Memory::charge(Memory::PLOT_OWNER, id, MEMORY_CATEGORY::DATA, -plot->isolatedBytes);
+		plot->isolatedBytes = 0;
 	}
 
-	void drawPlot(PLOT_ID id, HDC hdc, float const* axisLimits, POINT const* drawSpace) {
+	void drawPlot(PLOT_ID id, HDC hdc, double const* axisLimits, POINT const* drawSpace, int detail) {
 		Maps::PlotGuard guard(id);
-		Maps::plotPointerMap.at(id)->draw(hdc, axisLimits, drawSpace);
+		Plot::Plot* plt = Maps::plotPointerMap.at(id);
+		plt->detail = detail;
+		plt->draw(hdc, axisLimits, drawSpace);
 	}
 
 	void drawPlotLegend(PLOT_ID id, HDC hdc, RECT legendRect) {
@@ -127,6 +334,63 @@ namespace SimplePlot {
 		Maps::plotPointerMap.at(id)->drawLegend(hdc, legendRect);
 	}
 
+	void recordPlot(PLOT_ID id, Render::DrawList& list, double const* axisLimits, POINT const* drawSpace, int detail) {
+		Maps::PlotGuard guard(id);
+		Plot::Plot* plt = Maps::plotPointerMap.at(id);
+		plt->detail = detail;
+		plt->record(list, axisLimits, drawSpace);
+	}
+
+	void recordPlots(std::vector<PLOT_ID> const& ids, Render::DrawList* lists, long long* nanoseconds,
+		double const* axisLimits, POINT const* drawSpace, int detail) {
+		// Every plot's own mutex is taken up front and mapMutex let go, so the tasks themselves take no locks.
+		// A task that helps the pool with a nested parallelFor can then never wait on mapMutex while holding
+		// a plot that a PlotGuard elsewhere is waiting for. The plots are only tried under mapMutex: if one is
+		// busy, which takes another canvas recording it, all are let go and mapMutex with them before trying
+		// again, so nothing else waits on the registry in the meantime.
+		std::vector<Plot::Plot*> plts(ids.size());
+		std::deque<Locks::LockGuard> guards;
+		auto begin = std::chrono::steady_clock::now();
+		for (int attempt = 0; ; attempt++) {
+			{
+				Locks::LockGuard generalGuard(Maps::mapMutex, Maps::plotGuardMapSite);
+				std::vector<std::unique_lock<std::mutex>> held;
+				for (size_t i = 0; i < ids.size(); i++) {
+					plts[i] = Maps::plotPointerMap.at(ids[i]);
+					held.emplace_back(Maps::plotMutexMap.at(ids[i]), std::try_to_lock);
+					if (!held.back().owns_lock()) { break; }
+				}
+				if (held.size() == ids.size() && (held.empty() || held.back().owns_lock())) {
+					long long waited = attempt == 0 ? 0 :
+						std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+					for (std::unique_lock<std::mutex>& lock : held) {
+						guards.emplace_back(*lock.release(), Maps::recordingPlotSite, std::adopt_lock, waited);
+					}
+					break;
+				}
+			}
+			if (attempt < 8) {
+				std::this_thread::yield();
+			}
+			else {
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+			}
+		}
+		Render::getPool().parallelFor((int)ids.size(), [&](int i) {
+			Trace::Span span("record", "plot", ids[i]);
+			auto start = std::chrono::steady_clock::now();
+			lists[i].clear();
+			plts[i]->detail = detail;
+			plts[i]->record(lists[i], axisLimits, drawSpace);
+			nanoseconds[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		});
+	}
+
+	void recordPlotLegend(PLOT_ID id, Render::DrawList& list, RECT legendRect) {
+		Maps::PlotGuard guard(id);
+		Maps::plotPointerMap.at(id)->recordLegend(list, legendRect);
+	}
+
 	void associatePlot(PLOT_ID plotID, CANVAS_ID canvasID) {
 		Maps::PlotGuard guard(plotID);
 		Maps::plotPointerMap.at(plotID)->canvas = canvasID;
@@ -142,7 +406,7 @@ namespace SimplePlot {
 		return Maps::plotPointerMap.at(plotID)->canvas;
 	}
 
-	void setPlotAxisLimits(PLOT_ID id, int axisNum, float lowLimit, float highLimit) {
+	void setPlotAxisLimits(PLOT_ID id, int axisNum, double lowLimit, double highLimit) {
 		Maps::PlotGuard guard(id);// Necessary?
 		Plot::Plot* ptr = Maps::plotPointerMap.at(id);
 		if (ptr->numAxes <= axisNum) {
@@ -153,7 +417,7 @@ namespace SimplePlot {
 		ptr->setAxisLimits[axisNum * 2 + 1] = highLimit;
 		ptr->isSetAxisLimits[axisNum * 2 + 1] = true;
 	}
-	void setPlotLowerAxisLimit(PLOT_ID id, int axisNum, float lowLimit) {
+	void setPlotLowerAxisLimit(PLOT_ID id, int axisNum, double lowLimit) {
 		Maps::PlotGuard guard(id);// Necessary?
 		Plot::Plot* ptr = Maps::plotPointerMap.at(id);
 		if (ptr->numAxes <= axisNum) {
@@ -162,7 +426,7 @@ namespace SimplePlot {
 		ptr->setAxisLimits[axisNum * 2] = lowLimit;
 		ptr->isSetAxisLimits[axisNum * 2] = true;
 	}
-	void setPlotUpperAxisLimit(PLOT_ID id, int axisNum, float highLimit) {
+	void setPlotUpperAxisLimit(PLOT_ID id, int axisNum, double highLimit) {
 		Maps::PlotGuard guard(id);// Necessary?
 		Plot::Plot* ptr = Maps::plotPointerMap.at(id);
 		if (ptr->numAxes <= axisNum) {
@@ -171,6 +435,48 @@ namespace SimplePlot {
 		ptr->setAxisLimits[axisNum * 2 + 1] = highLimit;
 		ptr->isSetAxisLimits[axisNum * 2 + 1] = true;
 	}
+
+	void setPlotLogAxis(PLOT_ID id, int axisNum, bool logarithmic) {
+		Maps::PlotGuard guard(id);
+		Plot::Plot* ptr = Maps::plotPointerMap.at(id);
+		if (ptr->numAxes <= axisNum || (logarithmic && ptr->plotType == PLOT_TYPE::HISTOGRAM)) {
+			return;
+		}
+		if (ptr->logAxes[axisNum] != logarithmic) {
+			ptr->logAxes[axisNum] = logarithmic;
+			ptr->invalidateExtents();
+		}
+	}
+
+	void setPlotAxisOrigin(PLOT_ID id, int axisNum, long long origin) {
+		Maps::PlotGuard guard(id);
+		Plot::Plot* ptr = Maps::plotPointerMap.at(id);
+		if (ptr->numAxes <= axisNum) {
+			return;
+		}
+		if (ptr->axisOrigins[axisNum] != origin) {
+			ptr->axisOrigins[axisNum] = origin;
+			ptr->invalidateExtents();
+		}
+	}
+
+	void updatePlotData(PLOT_ID id) {
+		Maps::PlotGuard guard(id);
+		Plot::Plot* ptr = Maps::plotPointerMap.at(id);
+		ptr->dataVersion++;
+		ptr->appendBase = ptr->dataVersion;
+	}
+
+	void appendPlotData(PLOT_ID id, int newSize) {
+		Maps::PlotGuard guard(id);
+		Maps::plotPointerMap.at(id)->appendData(newSize);
+	}
+
+	void mergePlotSketch(PLOT_ID id, int axisNum, Sketch::KllSketch& into) {
+		Maps::PlotGuard guard(id);
+		Maps::plotPointerMap.at(id)->mergeSketch(axisNum, into);
+	}
+
 	std::wstring getPlotName(PLOT_ID id) {
 		Maps::PlotGuard guard(id);
 		return Maps::plotPointerMap.at(id)->name;
@@ -1,9 +1,16 @@
 #pragma once
+#include <cmath>
 #include <string>
+#include <type_traits>
 #include <windows.h>
 
 #include "../standard.h"
 #include "../colors.h"
+#include "../detail.h"
+#include "../memory.h"
+#include "../render/drawlist.h"
+#include "../sketch.h"
+#include "../transform.h"
 
 
 namespace SimplePlot {
@@ -11,6 +18,7 @@ namespace SimplePlot {
 		class Plot {
 		public:
 			Plot(PLOT_TYPE plotType, AXIS_TYPE axisType, int style, std::wstring name);
+			virtual ~Plot();
 			Plot(const Plot&) = delete;
 			Plot(Plot&&) = delete;
 			Plot& operator=(Plot const&) = delete;
@@ -18,44 +26,156 @@ namespace SimplePlot {
 
 			virtual void isolateData() = 0;
 			virtual void deleteData() = 0;
-			virtual void getAxisLimits(float* axisLimits) const = 0;
-			virtual void draw(HDC hdc, float const* axisLimits, POINT const* drawSpace) const = 0;
+			virtual void getAxisLimits(double* axisLimits) const = 0;
+			virtual void draw(HDC hdc, double const* axisLimits, POINT const* drawSpace) const = 0;
+			virtual void record(Render::DrawList& list, double const* axisLimits, POINT const* drawSpace) const = 0;
+
+			// Plots whose data is a flat array can grow in place, after which only the new values need looking
+			// at. The defaults opt out, and anything that can't be done incrementally is redone from scratch.
+			virtual int getDataSize() const { return 0; }
+			virtual bool resizeData(int newSize) { return false; }
+			virtual bool getRangeLimits(double* axisLimits, int begin, int end) const { return false; }// Like getAxisLimits, over [begin, end)
+			virtual void sketchData(int axisNum, int begin, int end, Sketch::KllSketch& sketch) const {}// Positions along the axis
+
+			// Bytes of the arrays the plot reads, which are the plot's own once it is isolated.
+			virtual long long getDataBytes() const { return 0; }
+			virtual long long getCacheBytes() const;
 
 			void drawLegend(HDC hdc, RECT legendRect);
-			void getGeneralAxisLimits(float* axisLimits, bool set) const;
+			void recordLegend(Render::DrawList& list, RECT legendRect) const;
+			void getGeneralAxisLimits(double* axisLimits, bool set, bool rescan = false);
+			void mergeSketch(int axisNum, Sketch::KllSketch& into);
+			void appendData(int newSize);
+			void invalidateExtents();
 
 			PLOT_ID id = SP_NULL_PLOT;
 			CANVAS_ID canvas = SP_NULL_CANVAS;
 			AXIS_TYPE axisType;
 			PLOT_TYPE plotType;
 			int numAxes;
-			float* setAxisLimits;
+			double* setAxisLimits;
 			bool* isSetAxisLimits;
+			bool* logAxes;// Per axis. Limits and positions on a log axis are in log10 of the data.
+			long long* axisOrigins;// Per axis. Limits and positions are relative to these, which time axes move near the data.
+			unsigned long long dataVersion = 0;// Bumped by updatePlotData and appendPlotData
+			unsigned long long appendBase = 0;// Versions from this one on differ only by values added at the end
+			bool isolated = false;// The plot holds a copy of the data, which can't grow
+			long long isolatedBytes = 0;// Charged to the plot while isolated
+			double* extents;// getAxisLimits as of extentsVersion; rescanning the data is the expensive part of a frame
+			bool extentsValid = false;
+			unsigned long long extentsVersion = 0;
+			int extentsSize = 0;
+			int detail = 0;// Level of detail for the frame being drawn, set by the canvas
 			std::wstring name;
 
 		protected:
+			bool penDown(LONG x) const;
+			void drawImage(HDC hdc, Render::Image const& image) const;// Blends an image with straight alpha onto hdc
+
+			// Draws a line through pixel positions from trace(add), which calls add(x, y) for each point in order,
+			// with non-finite coordinates where the line breaks. Dense lines lose detail as the canvas asks.
+			template<typename Trace>
+			void drawPath(HDC hdc, int points, POINT const* drawSpace, Trace&& trace) const {
+				if (Detail::shadesDensity(detail, points, drawSpace)) {
+					Detail::DensityShader shader(drawSpace, Render::pixelFromColorRef(style.forePenColor));
+					trace([&](float x, float y) { shader.add(x, y); });
+					drawImage(hdc, shader.finish());
+					return;
+				}
+				SelectObject(hdc, style.forePen);
+				Detail::Decimator decimator(Detail::decimationLevel(detail), [&](float x, float y, bool move) {
+					if (!move && penDown((LONG)x)) { LineTo(hdc, (LONG)x, (LONG)y); }
+					else { MoveToEx(hdc, (LONG)x, (LONG)y, NULL); }
+				});
+				trace([&](float x, float y) { decimator.add(x, y); });
+				decimator.finish();
+			}
+
+			template<typename Trace>
+			void recordPath(Render::DrawList& list, int points, POINT const* drawSpace, Trace&& trace) const {
+				if (Detail::shadesDensity(detail, points, drawSpace)) {
+					Detail::DensityShader shader(drawSpace, Render::pixelFromColorRef(style.forePenColor));
+					trace([&](float x, float y) { shader.add(x, y); });
+					Render::Image image = shader.finish();
+					if (image.width != 0) { list.drawImage(std::move(image)); }
+					return;
+				}
+				list.beginPath(Render::pixelFromColorRef(style.forePenColor), style.foreWidth);
+				Detail::Decimator decimator(Detail::decimationLevel(detail), [&](float x, float y, bool move) {
+					if (!move && penDown((LONG)x)) { list.lineTo(x, y); }
+					else { list.moveTo(x, y); }
+				});
+				trace([&](float x, float y) { decimator.add(x, y); });
+				decimator.finish();
+				list.endPath();
+			}
+
+			template<typename T>
+			void sketchAxis(T const* data, int size, int begin, int end, int axisNum, Transform::LogCache& logCache,
+				Sketch::KllSketch& sketch) const {
+				if (logAxes[axisNum]) {
+					float const* logs = logCache.get<T>(data, size, dataVersion);
+					for (int i = begin; i < end; i++) {
+						if (std::isfinite(logs[i])) { sketch.update(logs[i]); }
+					}
+				}
+				else {
+					for (int i = begin; i < end; i++) {
+						sketch.update(relative(data[i], axisNum));
+					}
+				}
+			}
+
+			// A value's position along an axis, relative to the axis origin; see Transform::relative.
+			template<typename T>
+			double relative(T value, int axisNum) const {
+				return Transform::relative(value, axisOrigins[axisNum]);
+			}
+
 			SimplePlot::Style::Style style;
 
 		private:
+			long long limitsBytes() const;
+
+			struct AxisSketch {
+				Sketch::KllSketch sketch;
+				bool valid = false;
+				unsigned long long version = 0;
+				int size = 0;// Values fed in so far
+			};
+			AxisSketch* sketches = nullptr;// Per axis, made when a percentile autoscale first asks
+
 			inline static PLOT_ID maxID = 0;
 		};
 	}
 
 	void deletePlot(PLOT_ID plot);
+	std::vector<PlotMemory> getPlotMemoryUsage();
 	void registerPlot(PLOT_ID, Plot::Plot* plt, PLOT_TYPE plotType);
 
 	AXIS_TYPE getPlotAxisType(PLOT_ID id);
 	PLOT_TYPE getPlotType(PLOT_ID id);
-	void getPlotAxisLimits(PLOT_ID id, float* axisLimits, bool set);
+	// rescan looks through data that isn't isolated even if updatePlotData hasn't been called since last time.
+	void getPlotAxisLimits(PLOT_ID id, double* axisLimits, bool set, bool rescan = false);
 	void isolatePlotData(PLOT_ID id);
 	void deletePlotData(PLOT_ID id);
-	void drawPlot(PLOT_ID id, HDC hdc, float const* axisLimits, POINT const* drawSpace);
+	void drawPlot(PLOT_ID id, HDC hdc, double const* axisLimits, POINT const* drawSpace, int detail = 0);
 	void drawPlotLegend(PLOT_ID id, HDC hdc, RECT legendRect);
+	void recordPlot(PLOT_ID id, Render::DrawList& list, double const* axisLimits, POINT const* drawSpace, int detail = 0);
+	// Records each plot into its own list, side by side on the pool, and times each one.
+	void recordPlots(std::vector<PLOT_ID> const& ids, Render::DrawList* lists, long long* nanoseconds,
+		double const* axisLimits, POINT const* drawSpace, int detail = 0);
+	void recordPlotLegend(PLOT_ID id, Render::DrawList& list, RECT legendRect);
 	void associatePlot(PLOT_ID plotID, CANVAS_ID canvasID);
 	void disassociatePlot(PLOT_ID plotID);
 	CANVAS_ID getPlotCanvas(PLOT_ID plotID);
-	void setPlotAxisLimits(PLOT_ID id, int axisNum, float lowLimit, float highLimit);
-	void setPlotLowerAxisLimit(PLOT_ID id, int axisNum, float lowLimit);
-	void setPlotUpperAxisLimit(PLOT_ID id, int axisNum, float highLimit);
+	void setPlotAxisLimits(PLOT_ID id, int axisNum, double lowLimit, double highLimit);
+	void setPlotLowerAxisLimit(PLOT_ID id, int axisNum, double lowLimit);
+	void setPlotUpperAxisLimit(PLOT_ID id, int axisNum, double highLimit);
+	void setPlotLogAxis(PLOT_ID id, int axisNum, bool logarithmic);
+	void setPlotAxisOrigin(PLOT_ID id, int axisNum, long long origin);
+	void updatePlotData(PLOT_ID id);// Call after changing the values a plot points to
+	void appendPlotData(PLOT_ID id, int newSize);// The plot's arrays now hold newSize values, the old ones unchanged
+	void mergePlotSketch(PLOT_ID id, int axisNum, Sketch::KllSketch& into);
 	std::wstring getPlotName(PLOT_ID id);
 }
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include "scatter.h"
+#pragma warning(disable:4244)
+
+#include "../stats.h"
+#include "../render/pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace SimplePlot::Scatter {
+	namespace {
+		// Upper bound on the memory used by the per-thread accumulation buffers.
+		const size_t maxScratchBytes = size_t(256) << 20;
+		const int lutSize = 256;
+		const int equalizeBins = 4096;
+
+		template<typename A>
+		void mapDensity(std::vector<A> const& density, NORMALIZATION normalization, std::vector<Render::Pixel> const& lut,
+			std::vector<Render::Pixel>& out) {
+			double maxDensity = 0;
+			for (A v : density) {
+				maxDensity = (std::max)(maxDensity, (double)v);
+			}
+			if (maxDensity <= 0) { return; }
+
+			// Histogram equalisation works on log densities so that a few very dense pixels don't
+			// squash everything else into the first bin.
+			std::vector<float> cdf;
+			double logMax = std::log1p(maxDensity);
+			if (normalization == NORMALIZATION::EQUALIZE) {
+				std::vector<int64_t> hist(equalizeBins, 0);
+				int64_t total = 0;
+				for (A v : density) {
+					if (v <= 0) { continue; }
+					hist[(std::min)(int(std::log1p((double)v) / logMax * equalizeBins), equalizeBins - 1)]++;
+					total++;
+				}
+				cdf.resize(equalizeBins);
+				int64_t running = 0;
+				for (int i = 0; i < equalizeBins; i++) {
+					running += hist[i];
+					cdf[i] = float(running) / total;
+				}
+			}
+
+			for (size_t p = 0; p < density.size(); p++) {
+				double v = (double)density[p];
+				if (v <= 0) { continue; }
+				double level;
+				switch (normalization) {
+				case NORMALIZATION::LINEAR:
+					level = v / maxDensity;
+					break;
+				case NORMALIZATION::EQUALIZE:
+					level = cdf[(std::min)(int(std::log1p(v) / logMax * equalizeBins), equalizeBins - 1)];
+					break;
+				case NORMALIZATION::LOG:
+				default:
+					level = std::log1p(v) / logMax;
+					break;
+				}
+				out[p] = lut[(std::min)((std::max)(int(level * (lutSize - 1) + 0.5), 0), lutSize - 1)];
+			}
+		}
+	}
+
+	template<typename X, typename Y>
+	Scatter<X, Y>::Scatter(X* xData, Y* yData, int sizeData, float* weights, NORMALIZATION normalization, int style, std::wstring name)
+		: Plot(PLOT_TYPE::SCATTER, AXIS_TYPE::CART_2D, style, name), xData(xData), yData(yData), weights(weights), sizeData(sizeData),
+		normalization(normalization) {
+		// Sparse pixels fade from the light brush colour towards the pen colour as density rises.
+		Render::Pixel low = Render::pixelFromColorRef(this->style.foreBrushColor);
+		Render::Pixel high = Render::pixelFromColorRef(this->style.forePenColor);
+		lut.resize(lutSize);
+		for (int i = 0; i < lutSize; i++) {
+			unsigned int t = i * 255 / (lutSize - 1);
+			lut[i] = Render::blendPixel(low, high, t) & 0x00ffffff;
+			lut[i] |= (96 + t * 159 / 255) << 24;
+		}
+	}
+
+	template<typename X, typename Y>
+	Scatter<X, Y>::~Scatter() {
+
+	}
+
+	template<typename X, typename Y>
+	void Scatter<X, Y>::getAxisLimits(double* axisLimits) const {
+		if (logAxes[0]) {
+			xLog.get<X>(xData, sizeData, dataVersion);
+			axisLimits[0] = xLog.minValue();
+			axisLimits[1] = xLog.maxValue();
+		}
+		else {
+			axisLimits[0] = relative(SimplePlot::Stats::minValue<X>(xData, sizeData), 0);
+			axisLimits[1] = relative(SimplePlot::Stats::maxValue<X>(xData, sizeData), 0);
+		}
+		if (logAxes[1]) {
+			yLog.get<Y>(yData, sizeData, dataVersion);
+			axisLimits[2] = yLog.minValue();
+			axisLimits[3] = yLog.maxValue();
+		}
+		else {
+			axisLimits[2] = relative(SimplePlot::Stats::minValue<Y>(yData, sizeData), 1);
+			axisLimits[3] = relative(SimplePlot::Stats::maxValue<Y>(yData, sizeData), 1);
+		}
+	}
+
+	template<typename X, typename Y>
+	int Scatter<X, Y>::getDataSize() const {
+		return sizeData;
+	}
+
+	template<typename X, typename Y>
+	bool Scatter<X, Y>::resizeData(int newSize) {
+		sizeData = newSize;
+		return true;
+	}
+
+	template<typename X, typename Y>
+	bool Scatter<X, Y>::getRangeLimits(double* axisLimits, int begin, int end) const {
+		if (logAxes[0] || logAxes[1]) { return false; }
+		axisLimits[0] = relative(SimplePlot::Stats::minValue<X>(xData + begin, end - begin), 0);
+		axisLimits[1] = relative(SimplePlot::Stats::maxValue<X>(xData + begin, end - begin), 0);
+		axisLimits[2] = relative(SimplePlot::Stats::minValue<Y>(yData + begin, end - begin), 1);
+		axisLimits[3] = relative(SimplePlot::Stats::maxValue<Y>(yData + begin, end - begin), 1);
+		return true;
+	}
+
+	template<typename X, typename Y>
+	void Scatter<X, Y>::sketchData(int axisNum, int begin, int end, Sketch::KllSketch& sketch) const {
+		if (axisNum == 0) {
+			sketchAxis<X>(xData, sizeData, begin, end, 0, xLog, sketch);
+		}
+		else if (axisNum == 1) {
+			sketchAxis<Y>(yData, sizeData, begin, end, 1, yLog, sketch);
+		}
+	}
+
+	template<typename X, typename Y>
+	template<typename A>
+	void Scatter<X, Y>::accumulate(std::vector<A>& density, int width, int height, double const* axisLimits) const {
+		// One pass over the data. Each chunk splats into its own buffer, and the buffers are summed
+		// afterwards, so no two threads ever write to the same counter.
+		size_t pixels = (size_t)width * height;
+		Render::Pool& pool = Render::getPool();
+		size_t affordable = (std::max)(maxScratchBytes / (pixels * sizeof(A)), (size_t)1);
+		int numChunks = (int)(std::min)({ (size_t)pool.size() + 1, affordable, (size_t)(sizeData / 65536 + 1) });
+
+		density.assign(pixels, 0);
+		std::vector<std::vector<A>> partial(numChunks - 1);
+		double scaleX = width / (axisLimits[1] - axisLimits[0]);
+		double scaleY = height / (axisLimits[3] - axisLimits[2]);
+		float const* xs = logAxes[0] ? xLog.get<X>(xData, sizeData, dataVersion) : nullptr;
+		float const* ys = logAxes[1] ? yLog.get<Y>(yData, sizeData, dataVersion) : nullptr;
+
+		pool.parallelFor(numChunks, [&](int chunk) {
+			std::vector<A>& local = chunk == 0 ? density : partial[chunk - 1];
+			if (chunk != 0) {
+				local.assign(pixels, 0);
+			}
+			int begin = int((long long)sizeData * chunk / numChunks);
+			int end = int((long long)sizeData * (chunk + 1) / numChunks);
+			for (int i = begin; i < end; i++) {
+				double fx = ((xs ? xs[i] : relative(xData[i], 0)) - axisLimits[0]) * scaleX;
+				double fy = (axisLimits[3] - (ys ? ys[i] : relative(yData[i], 1))) * scaleY;
+				if (!(fx >= 0 && fx <= width && fy >= 0 && fy <= height)) { continue; }
+				size_t index = (size_t)(std::min)((int)fy, height - 1) * width + (std::min)((int)fx, width - 1);
+				local[index] += weights ? (A)weights[i] : (A)1;
+			}
+		});
+
+		if (numChunks > 1) {
+			const int numBands = pool.size() + 1;
+			pool.parallelFor(numBands, [&](int band) {
+				size_t begin = pixels * band / numBands;
+				size_t end = pixels * (band + 1) / numBands;
+				for (std::vector<A> const& local : partial) {
+					for (size_t p = begin; p < end; p++) {
+						density[p] += local[p];
+					}
+				}
+			});
+		}
+	}
+
+	template<typename X, typename Y>
+	Render::Image Scatter<X, Y>::shade(double const* axisLimits, POINT const* drawSpace) const {
+		// axisPoints: {origin, endX, endY, farCorner}
+		Render::Image image;
+		image.left = drawSpace[0].x;
+		image.top = drawSpace[2].y;
+		image.width = (std::max)(drawSpace[1].x - drawSpace[0].x, 0L);
+		image.height = (std::max)(drawSpace[0].y - drawSpace[2].y, 0L);
+		if (image.width == 0 || image.height == 0 || sizeData == 0) {
+			image.width = image.height = 0;
+			return image;
+		}
+
+		image.pixels.assign((size_t)image.width * image.height, 0);
+		if (weights) {
+			std::vector<float> density;
+			accumulate(density, image.width, image.height, axisLimits);
+			mapDensity(density, normalization, lut, image.pixels);
+		}
+		else {
+			std::vector<uint32_t> density;
+			accumulate(density, image.width, image.height, axisLimits);
+			mapDensity(density, normalization, lut, image.pixels);
+		}
+		return image;
+	}
+
+	template<typename X, typename Y>
+	void Scatter<X, Y>::draw(HDC hdc, double const* axisLimits, POINT const* drawSpace) const {
+		drawImage(hdc, shade(axisLimits, drawSpace));
+	}
+
+	template<typename X, typename Y>
+	void Scatter<X, Y>::record(Render::DrawList& list, double const* axisLimits, POINT const* drawSpace) const {
+		Render::Image image = shade(axisLimits, drawSpace);
+		if (image.width == 0) { return; }
+		list.drawImage(std::move(image));
+	}
+
+	template<typename X, typename Y>
+	long long Scatter<X, Y>::getDataBytes() const {
+		return (long long)sizeData * (sizeof(X) + sizeof(Y) + (weights ? sizeof(float) : 0));
+	}
+
+	template<typename X, typename Y>
+	long long Scatter<X, Y>::getCacheBytes() const {
+		return Plot::getCacheBytes() + (long long)(lut.capacity() * sizeof(Render::Pixel)) + xLog.bytes() + yLog.bytes();
+	}
+
+	template<typename X, typename Y>
+	void Scatter<X, Y>::isolateData() {
+		X* newX = new X[sizeData];
+		memcpy(newX, xData, sizeof(X) * sizeData);
+		xData = newX;
+
+		Y* newY = new Y[sizeData];
+		memcpy(newY, yData, sizeof(Y) * sizeData);
+		yData = newY;
+
+		if (weights) {
+			float* newWeights = new float[sizeData];
+			memcpy(newWeights, weights, sizeof(float) * sizeData);
+			weights = newWeights;
+		}
+	}
+
+	template<typename X, typename Y>
+	void Scatter<X, Y>::deleteData() {
+		delete[] xData;
+		delete[] yData;
+		if (weights) delete[] weights;
+	}
+
+
+	template class Scatter<float, float>;
+	template class Scatter<double, float>;
+	template class Scatter<int, float>;
+	template class Scatter<float, double>;
+	template class Scatter<double, double>;
+	template class Scatter<int, double>;
+	template class Scatter<float, int>;
+	template class Scatter<double, int>;
+	template class Scatter<int, int>;
+}
+
+
+
+namespace SimplePlot {
+	template<typename X, typename Y>
+	PLOT_ID makeScatter(X* x, Y* y, int sizeData, int style, std::wstring name, NORMALIZATION normalization, float* weights) {
+		SimplePlot::Plot::Plot* plt = new SimplePlot::Scatter::Scatter(x, y, sizeData, weights, normalization, style, name);
+		PLOT_ID id = plt->id;
+		registerPlot(id, plt, PLOT_TYPE::SCATTER);
+		return id;
+	}
+
+	template PLOT_ID makeScatter<float, float>(float* x, float* y, int sizeData, int style, std::wstring name, NORMALIZATION normalization, float* weights);
+	template PLOT_ID makeScatter<double, float>(double* x, float* y, int sizeData, int style, std::wstring name, NORMALIZATION normalization, float* weights);
+	template PLOT_ID makeScatter<int, float>(int* x, float* y, int sizeData, int style, std::wstring name, NORMALIZATION normalization, float* weights);
+	template PLOT_ID makeScatter<float, double>(float* x, double* y, int sizeData, int style, std::wstring name, NORMALIZATION normalization, float* weights);
+	template PLOT_ID makeScatter<double, double>(double* x, double* y, int sizeData, int style, std::wstring name, NORMALIZATION normalization, float* weights);
+	template PLOT_ID makeScatter<int, double>(int* x, double* y, int sizeData, int style, std::wstring name, NORMALIZATION normalization, float* weights);
+	template PLOT_ID makeScatter<float, int>(float* x, int* y, int sizeData, int style, std::wstring name, NORMALIZATION normalization, float* weights);
+	template PLOT_ID makeScatter<double, int>(double* x, int* y, int sizeData, int style, std::wstring name, NORMALIZATION normalization, float* weights);
+	template PLOT_ID makeScatter<int, int>(int* x, int* y, int sizeData, int style, std::wstring name, NORMALIZATION normalization, float* weights);
+}
\ No newline at end of file
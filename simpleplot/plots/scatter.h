@@ -0,0 +1,49 @@
+#pragma once
+#include <vector>
+
+#include "plot.h"
+#include "../axis.h"
+#include "../transform.h"
+
+
+namespace SimplePlot::Scatter {
+	// A scatter plot for very large point clouds. Instead of drawing markers, points are splatted into a
+	// per-pixel count (or weight) buffer, which is then shaded through a colour lookup table.
+	template<typename X, typename Y>
+	class Scatter : public SimplePlot::Plot::Plot {
+	public:
+		Scatter(X* xData, Y* yData, int sizeData, float* weights, NORMALIZATION normalization, int style, std::wstring name);
+		~Scatter();
+
+
+	private:
+		void getAxisLimits(double* axisLimits) const override;
+		void draw(HDC hdc, double const* axisLimits, POINT const* drawSpace) const override;
+		void record(Render::DrawList& list, double const* axisLimits, POINT const* drawSpace) const override;
+		void isolateData() override;
+		void deleteData() override;
+		int getDataSize() const override;
+		bool resizeData(int newSize) override;
+		bool getRangeLimits(double* axisLimits, int begin, int end) const override;
+		void sketchData(int axisNum, int begin, int end, Sketch::KllSketch& sketch) const override;
+		long long getDataBytes() const override;
+		long long getCacheBytes() const override;
+		Render::Image shade(double const* axisLimits, POINT const* drawSpace) const;
+		template<typename A>
+		void accumulate(std::vector<A>& density, int width, int height, double const* axisLimits) const;
+
+		X* xData;
+		Y* yData;
+		float* weights;
+		int sizeData;
+		NORMALIZATION normalization;
+		std::vector<Render::Pixel> lut;
+		mutable Transform::LogCache xLog, yLog;
+	};
+}
+
+namespace SimplePlot {
+	template<typename X, typename Y>
+	extern PLOT_ID makeScatter(X* x, Y* y, int sizeData, int style = 0, std::wstring name = L"",
+		NORMALIZATION normalization = NORMALIZATION::LOG, float* weights = nullptr);
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 #pragma warning(disable:4244)
 
 #include "../stats.h"
+#include <cmath>
 #include <thread>
 #include <mutex>
 
@@ -17,57 +18,98 @@ namespace SimplePlot::Series {
 	}
 
 	template<typename X, typename Y>
-	void Series<X, Y>::getAxisLimits(float* axisLimits) const {
-		axisLimits[0] = 0;
-		axisLimits[1] = (float)(sizeData - 1) * skip;
-		axisLimits[2] = (float)SimplePlot::Stats::minValue<Y>(data, sizeData);
-		axisLimits[3] = (float)SimplePlot::Stats::maxValue<Y>(data, sizeData);
+	void Series<X, Y>::getAxisLimits(double* axisLimits) const {
+		axisLimits[0] = relative((X)0, 0);
+		axisLimits[1] = relative((X)((sizeData - 1) * skip), 0);
+		if (logAxes[0]) {
+			// The first sample sits at 0, which a log axis can't show.
+			axisLimits[0] = sizeData > 1 ? std::log10((double)skip) : 0;
+			axisLimits[1] = sizeData > 1 ? std::log10((double)((sizeData - 1) * skip)) : 1;
+		}
+		if (logAxes[1]) {
+			yLog.get<Y>(data, sizeData, dataVersion);
+			axisLimits[2] = yLog.minValue();
+			axisLimits[3] = yLog.maxValue();
+		}
+		else {
+			axisLimits[2] = relative(SimplePlot::Stats::minValue<Y>(data, sizeData), 1);
+			axisLimits[3] = relative(SimplePlot::Stats::maxValue<Y>(data, sizeData), 1);
+		}
+	}
+
+	template<typename X, typename Y>
+	int Series<X, Y>::getDataSize() const {
+		return sizeData;
+	}
+
+	template<typename X, typename Y>
+	bool Series<X, Y>::resizeData(int newSize) {
+		sizeData = newSize;
+		return true;
+	}
+
+	template<typename X, typename Y>
+	bool Series<X, Y>::getRangeLimits(double* axisLimits, int begin, int end) const {
+		if (logAxes[0] || logAxes[1]) { return false; }
+		// The samples start at 0 whichever of them are new.
+		axisLimits[0] = relative((X)0, 0);
+		axisLimits[1] = relative((X)((end - 1) * skip), 0);
+		axisLimits[2] = relative(SimplePlot::Stats::minValue<Y>(data + begin, end - begin), 1);
+		axisLimits[3] = relative(SimplePlot::Stats::maxValue<Y>(data + begin, end - begin), 1);
+		return true;
 	}
 
 	template<typename X, typename Y>
-	void Series<X, Y>::draw(HDC hdc, float const* axisLimits, POINT const* drawSpace) const {
+	void Series<X, Y>::sketchData(int axisNum, int begin, int end, Sketch::KllSketch& sketch) const {
+		if (axisNum == 0) {
+			for (int i = begin; i < end; i++) {
+				double position = logAxes[0] ? std::log10((double)(i * skip)) : relative((X)(i * skip), 0);
+				if (std::isfinite(position)) { sketch.update(position); }
+			}
+		}
+		else if (axisNum == 1) {
+			sketchAxis<Y>(data, sizeData, begin, end, 1, yLog, sketch);
+		}
+	}
+
+	template<typename X, typename Y>
+	template<typename Add>
+	void Series<X, Y>::trace(double const* axisLimits, POINT const* drawSpace, Add&& add) const {
 		// axisLimits: {minX, maxX, minY, maxY}
 		// axisPoints: {origin, endX, endY, farCorner}
-		SelectObject(hdc, style.forePen);
-
-		LONG y = drawSpace[0].y + (data[0] - axisLimits[2]) / (axisLimits[3] - axisLimits[2]) * (drawSpace[2].y - drawSpace[0].y);
-		MoveToEx(hdc, drawSpace[0].x, y, NULL);
-		for (int i = 1; i < sizeData; i++) {
-			LONG x = drawSpace[0].x + (i * skip) / (axisLimits[1] - axisLimits[0])  *(drawSpace[1].x - drawSpace[0].x);
-			LONG y = drawSpace[0].y + ((float)data[i] - axisLimits[2]) / (axisLimits[3] - axisLimits[2]) * (drawSpace[2].y - drawSpace[0].y);
-			switch (style.foreStyle) {
-			case SP_SOLID:
-				LineTo(hdc, x, y);
-				break;
-			case SP_DASH:
-				if ((x / 10) % 2 == 0) { LineTo(hdc, x, y); }
-				else { MoveToEx(hdc, x, y, NULL); }
-				break;
-			case SP_DOT:
-				if ((x / 2) % 2 == 0) { LineTo(hdc, x, y); }
-				else { MoveToEx(hdc, x, y, NULL); }
-				break;
-			case SP_DASHDOT:
-				if ((x / 10) % 2 == 0) { LineTo(hdc, x, y); }
-				else {
-					if ((x / 10) == 4 || (x / 10) == 5) { LineTo(hdc, x, y); }
-					else { MoveToEx(hdc, x, y, NULL); }
-				}
-				break;
-			case SP_DASHDOTDOT:
-				if ((x / 10) % 3 == 0) { LineTo(hdc, x, y); }
-				else {
-					if ((x / 10) % 3 == 1 && ((x / 10) == 6 || (x / 10) == 7)) { LineTo(hdc, x, y); }
-					else if ((x / 10) % 3 == 2 && ((x / 10) == 2 || (x / 10) == 3)) { LineTo(hdc, x, y); }
-					else { MoveToEx(hdc, x, y, NULL); }
-				}
-				break;
-			default:
-				break;
-			}
+		// Sample positions are generated rather than stored, so only y has a cached log.
+		float const* ys = logAxes[1] ? yLog.get<Y>(data, sizeData, dataVersion) : nullptr;
+		Transform::AffineMap mapX(axisLimits[0], axisLimits[1], drawSpace[0].x, drawSpace[1].x);
+		Transform::AffineMap mapY(axisLimits[2], axisLimits[3], drawSpace[0].y, drawSpace[2].y);
+		for (int i = 0; i < sizeData; i++) {
+			double fx = logAxes[0] ? std::log10((double)(i * skip)) : relative((X)(i * skip), 0);
+			double fy = ys ? ys[i] : relative(data[i], 1);
+			float x, y;
+			Transform::mapPoint(mapX, mapY, fx, fy, x, y);
+			add(x, y);
 		}
 	}
 
+	template<typename X, typename Y>
+	void Series<X, Y>::draw(HDC hdc, double const* axisLimits, POINT const* drawSpace) const {
+		drawPath(hdc, sizeData, drawSpace, [&](auto&& add) { trace(axisLimits, drawSpace, add); });
+	}
+
+	template<typename X, typename Y>
+	void Series<X, Y>::record(Render::DrawList& list, double const* axisLimits, POINT const* drawSpace) const {
+		recordPath(list, sizeData, drawSpace, [&](auto&& add) { trace(axisLimits, drawSpace, add); });
+	}
+
+	template<typename X, typename Y>
+	long long Series<X, Y>::getDataBytes() const {
+		return (long long)sizeData * sizeof(Y);
+	}
+
+	template<typename X, typename Y>
+	long long Series<X, Y>::getCacheBytes() const {
+		return Plot::getCacheBytes() + yLog.bytes();
+	}
+
 	template<typename X, typename Y>
 	void Series<X, Y>::isolateData() {
 		Y* newData = new Y[sizeData];
@@ -0,0 +1,152 @@
+#include "profile.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+
+namespace SimplePlot::Profile {
+	namespace {
+		PercentileStats percentiles(std::vector<long long>& values) {
+			// Nearest rank
+			PercentileStats stats;
+			if (values.empty()) { return stats; }
+			std::sort(values.begin(), values.end());
+			auto at = [&values](double p) {
+				size_t rank = (size_t)std::ceil(p * values.size());
+				return values[(std::min)((std::max)(rank, (size_t)1), values.size()) - 1] / 1e6;
+			};
+			stats.p50 = at(0.50);
+			stats.p95 = at(0.95);
+			stats.p99 = at(0.99);
+			return stats;
+		}
+	}
+
+	FrameProfiler::~FrameProfiler() {
+		delete[] slots.load();
+	}
+
+	void FrameProfiler::setEnabled(bool enabled_) {
+		if (enabled_ && !slots.load(std::memory_order_acquire)) {
+			Slot* fresh = new Slot[SP_PROFILE_FRAMES];
+			Slot* expected = nullptr;
+			if (!slots.compare_exchange_strong(expected, fresh, std::memory_order_acq_rel)) {
+				delete[] fresh;
+			}
+		}
+		enabled.store(enabled_, std::memory_order_relaxed);
+	}
+
+	void FrameProfiler::push(FrameRecord const& record) {
+		Slot* ring = slots.load(std::memory_order_acquire);
+		if (!ring) { return; }
+		Slot& slot = ring[written.fetch_add(1, std::memory_order_relaxed) % SP_PROFILE_FRAMES];
+		unsigned int sequence = slot.sequence.load(std::memory_order_relaxed);
+		if ((sequence & 1) || !slot.sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_relaxed)) {
+			return;// Another frame is writing this slot, a whole ring ago; drop this one
+		}
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.total.store(record.total, std::memory_order_relaxed);
+		for (int i = 0; i < NUM_PHASES; i++) {
+			slot.phases[i].store(record.phases[i], std::memory_order_relaxed);
+		}
+		slot.numPlots.store(record.numPlots, std::memory_order_relaxed);
+		for (int i = 0; i < record.numPlots; i++) {
+			slot.plotIDs[i].store(record.plotIDs[i], std::memory_order_relaxed);
+			slot.plotTimes[i].store(record.plotTimes[i], std::memory_order_relaxed);
+		}
+		slot.sequence.store(sequence + 2, std::memory_order_release);
+	}
+
+	FrameStats FrameProfiler::getStats() const {
+		FrameStats stats;
+		Slot const* ring = slots.load(std::memory_order_acquire);
+		if (!ring) { return stats; }
+
+		std::vector<long long> totals;
+		std::vector<long long> phases[NUM_PHASES];
+		std::map<PLOT_ID, std::vector<long long>> plots;
+		unsigned long long end = written.load(std::memory_order_relaxed);
+		unsigned long long begin = end > SP_PROFILE_FRAMES ? end - SP_PROFILE_FRAMES : 0;
+		FrameRecord record;
+		for (unsigned long long i = begin; i < end; i++) {
+			Slot const& slot = ring[i % SP_PROFILE_FRAMES];
+			unsigned int before = slot.sequence.load(std::memory_order_acquire);
+			if ((before & 1) || before == 0) { continue; }
+			record.total = slot.total.load(std::memory_order_relaxed);
+			for (int p = 0; p < NUM_PHASES; p++) {
+				record.phases[p] = slot.phases[p].load(std::memory_order_relaxed);
+			}
+			record.numPlots = (std::min)(slot.numPlots.load(std::memory_order_relaxed), SP_PROFILE_MAX_PLOTS);
+			for (int p = 0; p < record.numPlots; p++) {
+				record.plotIDs[p] = slot.plotIDs[p].load(std::memory_order_relaxed);
+				record.plotTimes[p] = slot.plotTimes[p].load(std::memory_order_relaxed);
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.sequence.load(std::memory_order_relaxed) != before) { continue; }
+
+			totals.push_back(record.total);
+			for (int p = 0; p < NUM_PHASES; p++) {
+				phases[p].push_back(record.phases[p]);
+			}
+			for (int p = 0; p < record.numPlots; p++) {
+				plots[record.plotIDs[p]].push_back(record.plotTimes[p]);
+			}
+		}
+
+		stats.frames = (int)totals.size();
+		stats.total = percentiles(totals);
+		stats.limits = percentiles(phases[LIMITS]);
+		stats.axes = percentiles(phases[AXES]);
+		stats.legend = percentiles(phases[LEGEND]);
+		stats.present = percentiles(phases[PRESENT]);
+		for (auto& entry : plots) {
+			stats.plots.push_back({ entry.first, percentiles(entry.second) });
+		}
+		return stats;
+	}
+
+	FrameTimer::FrameTimer(FrameProfiler* profiler) : profiler(profiler), active(profiler && profiler->isEnabled()) {
+		if (active) {
+			start = Clock::now();
+			last = start;
+		}
+	}
+
+	void FrameTimer::plot(PLOT_ID id) {
+		if (!active) { return; }
+		if (record.numPlots < SP_PROFILE_MAX_PLOTS) {
+			record.plotIDs[record.numPlots] = id;
+			record.plotTimes[record.numPlots] = 0;
+			charge(record.plotTimes[record.numPlots]);
+			record.numPlots++;
+		}
+		else {
+			last = Clock::now();
+		}
+	}
+
+	void FrameTimer::plot(PLOT_ID id, long long nanoseconds) {
+		if (!active || record.numPlots >= SP_PROFILE_MAX_PLOTS) { return; }
+		record.plotIDs[record.numPlots] = id;
+		record.plotTimes[record.numPlots] = nanoseconds;
+		record.numPlots++;
+	}
+
+	void FrameTimer::skip() {
+		if (active) { last = Clock::now(); }
+	}
+
+	void FrameTimer::finish() {
+		if (!active) { return; }
+		record.total = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+		profiler->push(record);
+		active = false;
+	}
+
+	void FrameTimer::charge(long long& slot) {
+		Clock::time_point now = Clock::now();
+		slot += std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count();
+		last = now;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "standard.h"
+
+
+namespace SimplePlot {
+	struct PercentileStats {
+		double p50 = 0;// Milliseconds
+		double p95 = 0;
+		double p99 = 0;
+	};
+
+	struct PlotFrameStats {
+		PLOT_ID plot = SP_NULL_PLOT;
+		PercentileStats time;
+	};
+
+	// Over the last SP_PROFILE_FRAMES frames. On screen, plots draw themselves with GDI and present is the blit
+	// to the window; offscreen, plots only record into the draw list and present is the rasterization.
+	struct FrameStats {
+		int frames = 0;
+		PercentileStats total;
+		PercentileStats limits;// getPlotAxisLimits, autoscale and links
+		PercentileStats axes;// Layout, grid and axes
+		PercentileStats legend;// Title and legend
+		PercentileStats present;
+		std::vector<PlotFrameStats> plots;
+	};
+
+	namespace Profile {
+		enum PHASE {
+			LIMITS,
+			AXES,
+			LEGEND,
+			PRESENT,
+			NUM_PHASES,
+		};
+
+		struct FrameRecord {
+			long long total = 0;// Nanoseconds
+			long long phases[NUM_PHASES] = { 0 };
+			int numPlots = 0;// Plots past SP_PROFILE_MAX_PLOTS are counted in total only
+			PLOT_ID plotIDs[SP_PROFILE_MAX_PLOTS];
+			long long plotTimes[SP_PROFILE_MAX_PLOTS];
+		};
+
+		// A ring of recent frame timings. Frames are written and read without locks: each slot carries a sequence
+		// number that is odd while it is being written, and readers skip slots that were odd or changed while
+		// they were copied. The ring is only allocated once profiling is first turned on.
+		class FrameProfiler {
+		public:
+			FrameProfiler() = default;
+			~FrameProfiler();
+			FrameProfiler(FrameProfiler const&) = delete;
+			FrameProfiler& operator=(FrameProfiler const&) = delete;
+
+			void setEnabled(bool enabled_);
+			bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+			void push(FrameRecord const& record);
+			FrameStats getStats() const;
+
+		private:
+			struct Slot {
+				std::atomic<unsigned int> sequence = 0;
+				std::atomic<long long> total = 0;
+				std::atomic<long long> phases[NUM_PHASES] = {};
+				std::atomic<int> numPlots = 0;
+				std::atomic<PLOT_ID> plotIDs[SP_PROFILE_MAX_PLOTS] = {};
+				std::atomic<long long> plotTimes[SP_PROFILE_MAX_PLOTS] = {};
+			};
+
+			std::atomic<bool> enabled = false;
+			std::atomic<Slot*> slots = nullptr;
+			std::atomic<unsigned long long> written = 0;
+		};
+
+		// Times one frame. Each call charges the time since the previous call to a phase or a plot. When the
+		// profiler is off, every call is a single branch.
+		class FrameTimer {
+		public:
+			FrameTimer(FrameProfiler* profiler = nullptr);// nullptr: never records
+
+			void phase(PHASE phase) {
+				if (active) { charge(record.phases[phase]); }
+			}
+			void plot(PLOT_ID id);
+			// For plots drawn side by side on other threads, each timed on its own. skip() afterwards leaves the wait
+			// for them out of the next phase; it still counts towards the total.
+			void plot(PLOT_ID id, long long nanoseconds);
+			void skip();
+			void finish();
+
+		private:
+			typedef std::chrono::steady_clock Clock;
+			void charge(long long& slot);
+
+			FrameProfiler* profiler;
+			bool active;
+			Clock::time_point start;
+			Clock::time_point last;
+			FrameRecord record;
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "aaline.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SP_AALINE_SSE2
+#include <emmintrin.h>
+#endif
+
+
+namespace SimplePlot::Render {
+	namespace {
+		struct SegmentSetup {
+			float ax, ay;// Start point
+			float ux, uy;// Direction (end - start)
+			float invLen2;// 1 / |direction|^2, or 0 for a single point
+			float limit;// Half the pen width plus half a pixel: the distance at which coverage reaches 0
+		};
+
+		inline int clampToInt(float v) {
+			return (int)(std::max)((std::min)(v, 1e9f), -1e9f);
+		}
+
+		// Coverage of the four pixels at x = px .. px + 3 on a row dy below the segment start, merged
+		// into out with max. Coverage is 1 - (distance to the segment - half width), clamped to [0, 1].
+		inline void coverGroup(SegmentSetup const& s, float px, float dy, uint8_t* out) {
+#ifdef SP_AALINE_SSE2
+			const __m128 zero = _mm_setzero_ps();
+			const __m128 one = _mm_set1_ps(1.0f);
+			__m128 dxv = _mm_sub_ps(_mm_add_ps(_mm_set1_ps(px), _mm_set_ps(3, 2, 1, 0)), _mm_set1_ps(s.ax));
+			__m128 dyv = _mm_set1_ps(dy);
+			__m128 ux = _mm_set1_ps(s.ux);
+			__m128 uy = _mm_set1_ps(s.uy);
+
+			__m128 t = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(dxv, ux), _mm_mul_ps(dyv, uy)), _mm_set1_ps(s.invLen2));
+			t = _mm_min_ps(_mm_max_ps(t, zero), one);
+			__m128 ex = _mm_sub_ps(dxv, _mm_mul_ps(t, ux));
+			__m128 ey = _mm_sub_ps(dyv, _mm_mul_ps(t, uy));
+			__m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)));
+			__m128 c = _mm_min_ps(_mm_max_ps(_mm_sub_ps(_mm_set1_ps(s.limit), dist), zero), one);
+
+			__m128i ci = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+			ci = _mm_packs_epi32(ci, ci);
+			ci = _mm_packus_epi16(ci, ci);
+			int32_t existing;
+			memcpy(&existing, out, 4);
+			int32_t merged = _mm_cvtsi128_si32(_mm_max_epu8(ci, _mm_cvtsi32_si128(existing)));
+			memcpy(out, &merged, 4);
+#else
+			for (int lane = 0; lane < 4; lane++) {
+				float dxv = (px + lane) - s.ax;
+				float t = (dxv * s.ux + dy * s.uy) * s.invLen2;
+				t = (std::min)((std::max)(t, 0.0f), 1.0f);
+				float ex = dxv - t * s.ux;
+				float ey = dy - t * s.uy;
+				float dist = std::sqrt(ex * ex + ey * ey);
+				float c = (std::min)((std::max)(s.limit - dist, 0.0f), 1.0f);
+				uint8_t ci = (uint8_t)(int)(c * 255.0f + 0.5f);
+				out[lane] = (std::max)(out[lane], ci);
+			}
+#endif
+		}
+	}
+
+	void CoverageMask::reset(int left_, int top_, int width_, int height_) {
+		left = left_;
+		top = top_;
+		int newStride = (width_ + 3) & ~3;
+		if (newStride != stride || height_ != height) {
+			stride = newStride;
+			width = width_;
+			height = height_;
+			values.assign((size_t)stride * height, 0);
+			dirtyLeft = stride;
+			dirtyRight = 0;
+			dirtyTop = height;
+			dirtyBottom = 0;
+		}
+		else {
+			width = width_;
+			clear();
+		}
+	}
+
+	void CoverageMask::clear() {
+		for (int y = dirtyTop; y < dirtyBottom; y++) {
+			memset(row(y) + dirtyLeft, 0, dirtyRight - dirtyLeft);
+		}
+		dirtyLeft = stride;
+		dirtyRight = 0;
+		dirtyTop = height;
+		dirtyBottom = 0;
+	}
+
+	void coverSegments(CoverageMask& mask, Segment const* segments, int count, float width) {
+		float halfWidth = width * 0.5f;
+		float reach = halfWidth + 1.0f;
+
+		for (int i = 0; i < count; i++) {
+			Segment const& seg = segments[i];
+			SegmentSetup s;
+			s.ax = seg.x0;
+			s.ay = seg.y0;
+			s.ux = seg.x1 - seg.x0;
+			s.uy = seg.y1 - seg.y0;
+			float len2 = s.ux * s.ux + s.uy * s.uy;
+			float len = std::sqrt(len2);
+			s.invLen2 = len2 > 0 ? 1.0f / len2 : 0.0f;
+			s.limit = halfWidth + 0.5f;
+
+			float minX = (std::min)(seg.x0, seg.x1) - reach;
+			float maxX = (std::max)(seg.x0, seg.x1) + reach;
+			float minY = (std::min)(seg.y0, seg.y1) - reach;
+			float maxY = (std::max)(seg.y0, seg.y1) + reach;
+			int rowBegin = (std::max)(clampToInt(std::ceil(minY)) - mask.top, 0);
+			int rowEnd = (std::min)(clampToInt(std::floor(maxY)) - mask.top, mask.height - 1);
+
+			for (int r = rowBegin; r <= rowEnd; r++) {
+				float py = (float)(mask.top + r);
+				// Horizontal extent of the pen's band around the segment on this row.
+				float xs = minX;
+				float xe = maxX;
+				if (s.uy != 0) {
+					float xc = s.ax + (py - s.ay) * s.ux / s.uy;
+					float half = reach * len / std::fabs(s.uy);
+					xs = (std::max)(xs, xc - half);
+					xe = (std::min)(xe, xc + half);
+				}
+				int colBegin = (std::max)(clampToInt(std::ceil(xs)) - mask.left, 0);
+				int colEnd = (std::min)(clampToInt(std::floor(xe)) - mask.left, mask.width - 1);
+				if (colBegin > colEnd) { continue; }
+
+				colBegin &= ~3;
+				uint8_t* row = mask.row(r);
+				float dy = py - s.ay;
+				for (int c = colBegin; c <= colEnd; c += 4) {
+					coverGroup(s, (float)(mask.left + c), dy, row + c);
+				}
+
+				mask.dirtyLeft = (std::min)(mask.dirtyLeft, colBegin);
+				mask.dirtyRight = (std::max)(mask.dirtyRight, (std::min)((colEnd & ~3) + 4, mask.stride));
+				mask.dirtyTop = (std::min)(mask.dirtyTop, r);
+				mask.dirtyBottom = (std::max)(mask.dirtyBottom, r + 1);
+			}
+		}
+	}
+
+	void blendCoverage(Framebuffer& fb, CoverageMask const& mask, Pixel color) {
+		int right = (std::min)(mask.dirtyRight, mask.width);
+		for (int y = mask.dirtyTop; y < mask.dirtyBottom; y++) {
+			Pixel* dst = fb.row(mask.top + y) + mask.left;
+			uint8_t const* cov = mask.row(y);
+			for (int x = mask.dirtyLeft; x < right; x++) {
+				unsigned int a = cov[x];
+				if (a == 0) { continue; }
+				dst[x] = a == 255 ? color : blendPixel(dst[x], color, a);
+			}
+		}
+	}
+
+	void drawSegmentsAA(Framebuffer& fb, Segment const* segments, int count, float width, Pixel color) {
+		CoverageMask mask;
+		mask.reset(0, 0, fb.width, fb.height);
+		coverSegments(mask, segments, count, width);
+		blendCoverage(fb, mask, color);
+	}
+}
\ No newline at end of file
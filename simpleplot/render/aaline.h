@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "framebuffer.h"
+
+
+namespace SimplePlot::Render {
+	struct Segment {
+		float x0, y0, x1, y1;
+	};
+
+	// An 8 bit coverage buffer for a rectangle of the canvas. Rows are padded to a multiple of four
+	// pixels so the SIMD kernel always works on whole groups and never needs a scalar tail.
+	class CoverageMask {
+	public:
+		void reset(int left, int top, int width, int height);
+		void clear();
+		uint8_t* row(int y) { return values.data() + (size_t)y * stride; }
+		uint8_t const* row(int y) const { return values.data() + (size_t)y * stride; }
+		bool empty() const { return dirtyTop >= dirtyBottom; }
+
+		int left = 0;
+		int top = 0;
+		int width = 0;
+		int height = 0;
+		int stride = 0;
+
+		// Bounds of the rows and columns touched since the last clear, relative to left / top.
+		int dirtyLeft = 0, dirtyTop = 0, dirtyRight = 0, dirtyBottom = 0;
+
+	private:
+		std::vector<uint8_t> values;
+	};
+
+	// Accumulates the anti-aliased coverage of a batch of segments drawn with a round pen of the given
+	// width (in pixels; 1, 2 and 3 correspond to SP_THIN, SP_MEDIUM and SP_THICK). Coverage is combined
+	// with max rather than summed, so the joints of a polyline are not drawn twice. Integer
+	// coordinates are pixel centres, as in GDI.
+	void coverSegments(CoverageMask& mask, Segment const* segments, int count, float width);
+
+	// Blends color into the framebuffer wherever the mask has coverage.
+	void blendCoverage(Framebuffer& fb, CoverageMask const& mask, Pixel color);
+
+	// Convenience wrapper for drawing one batch straight into a framebuffer.
+	void drawSegmentsAA(Framebuffer& fb, Segment const* segments, int count, float width, Pixel color);
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "drawlist.h"
+
+
+namespace SimplePlot::Render {
+	void DrawList::clear() {
+		primitives.clear();
+		points.clear();
+		images.clear();
+		masks.clear();
+		runOpen = false;
+	}
+
+	long long DrawList::bytes() const {
+		long long total = (long long)(primitives.capacity() * sizeof(Primitive) + points.capacity() * sizeof(float) +
+			images.capacity() * sizeof(Image) + masks.capacity() * sizeof(masks[0]));
+		for (Image const& image : images) {
+			total += (long long)(image.pixels.capacity() * sizeof(Pixel));
+		}
+		return total;
+	}
+
+	void DrawList::fillRect(float left, float top, float right, float bottom, Pixel color) {
+		closeRun();
+		primitives.push_back({ PRIMITIVE::RECT, color, 0, (int)(points.size() / 2), 2 });
+		points.push_back(left);
+		points.push_back(top);
+		points.push_back(right);
+		points.push_back(bottom);
+	}
+
+	void DrawList::drawImage(Image&& image) {
+		closeRun();
+		primitives.push_back({ PRIMITIVE::IMAGE, 0, 0, (int)(points.size() / 2), 2, (int)images.size() });
+		points.push_back((float)image.left);
+		points.push_back((float)image.top);
+		points.push_back((float)(image.left + image.width));
+		points.push_back((float)(image.top + image.height));
+		images.push_back(std::move(image));
+	}
+
+	void DrawList::drawMask(int left, int top, std::shared_ptr<Mask const> const& mask, Pixel color) {
+		if (!mask || mask->width == 0 || mask->height == 0) { return; }
+		closeRun();
+		primitives.push_back({ PRIMITIVE::MASK, color, 0, (int)(points.size() / 2), 2, (int)masks.size() });
+		points.push_back((float)left);
+		points.push_back((float)top);
+		points.push_back((float)(left + mask->width));
+		points.push_back((float)(top + mask->height));
+		masks.push_back(mask);
+	}
+
+	void DrawList::beginPath(Pixel color, int width) {
+		closeRun();
+		pathColor = color;
+		pathWidth = width;
+	}
+
+	void DrawList::moveTo(float x, float y) {
+		closeRun();
+		penX = x;
+		penY = y;
+	}
+
+	void DrawList::lineTo(float x, float y) {
+		if (!runOpen) {
+			primitives.push_back({ PRIMITIVE::POLYLINE, pathColor, pathWidth, (int)(points.size() / 2), 1 });
+			points.push_back(penX);
+			points.push_back(penY);
+			runOpen = true;
+		}
+		points.push_back(x);
+		points.push_back(y);
+		primitives.back().count++;
+		penX = x;
+		penY = y;
+	}
+
+	void DrawList::endPath() {
+		closeRun();
+	}
+
+	void DrawList::append(DrawList&& layer) {
+		closeRun();
+		int pointBase = (int)(points.size() / 2);
+		int imageBase = (int)images.size();
+		int maskBase = (int)masks.size();
+		for (Primitive prim : layer.primitives) {
+			prim.first += pointBase;
+			if (prim.type == PRIMITIVE::IMAGE) { prim.image += imageBase; }
+			else if (prim.type == PRIMITIVE::MASK) { prim.image += maskBase; }
+			primitives.push_back(prim);
+		}
+		points.insert(points.end(), layer.points.begin(), layer.points.end());
+		for (Image& image : layer.images) {
+			images.push_back(std::move(image));
+		}
+		masks.insert(masks.end(), layer.masks.begin(), layer.masks.end());
+	}
+
+	void DrawList::closeRun() {
+		runOpen = false;
+	}
+}
\ No newline at end of file
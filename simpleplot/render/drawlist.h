@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "framebuffer.h"
+
+
+namespace SimplePlot::Render {
+	enum class PRIMITIVE {
+		POLYLINE,
+		RECT,
+		IMAGE,
+		MASK,
+	};
+
+	struct Primitive {
+		PRIMITIVE type;
+		Pixel color;
+		int width;
+		int first;// Index of the first point in DrawList::points
+		int count;// Number of points
+		int image = -1;// Index into DrawList::images, or DrawList::masks for MASK
+	};
+
+	// A block of pixels with straight (not premultiplied) alpha.
+	struct Image {
+		int left;
+		int top;
+		int width;
+		int height;
+		std::vector<Pixel> pixels;
+	};
+
+	// An 8 bit coverage mask, such as a rendered run of text, drawn in a single colour. Masks are shared
+	// rather than copied into the draw list, so a cached mask costs nothing to draw again next frame.
+	struct Mask {
+		int width = 0;
+		int height = 0;
+		std::vector<uint8_t> coverage;
+	};
+
+	// A resolution-independent record of one frame, in pixel coordinates. The interface follows GDI
+	// (MoveToEx / LineTo / FillRect) so that plots can record exactly what they would otherwise draw.
+	class DrawList {
+	public:
+		void clear();
+
+		void fillRect(float left, float top, float right, float bottom, Pixel color);
+		void drawImage(Image&& image);
+		void drawMask(int left, int top, std::shared_ptr<Mask const> const& mask, Pixel color);
+		void beginPath(Pixel color, int width);
+		void moveTo(float x, float y);
+		void lineTo(float x, float y);
+		void endPath();
+		void append(DrawList&& layer);// Draws layer's primitives after this list's; layer's images are moved out
+		long long bytes() const;// Heap memory held, not counting the shared masks
+
+		std::vector<Primitive> primitives;
+		std::vector<float> points;// x, y pairs
+		std::vector<Image> images;
+		std::vector<std::shared_ptr<Mask const>> masks;
+
+	private:
+		void closeRun();
+
+		Pixel pathColor = 0;
+		int pathWidth = 1;
+		float penX = 0;
+		float penY = 0;
+		bool runOpen = false;
+	};
+}
\ No newline at end of file
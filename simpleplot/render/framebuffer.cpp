@@ -0,0 +1,17 @@
+#include "framebuffer.h"
+#include <algorithm>
+#include <stdexcept>
+
+
+namespace SimplePlot::Render {
+	Framebuffer::Framebuffer(int width, int height) : width(width), height(height) {
+		if (width <= 0 || height <= 0) {
+			throw std::invalid_argument("Framebuffer dimensions must be positive");
+		}
+		pixels.resize((size_t)width * height);
+	}
+
+	void Framebuffer::clear(Pixel color) {
+		std::fill(pixels.begin(), pixels.end(), color);
+	}
+}
\ No newline at end of file
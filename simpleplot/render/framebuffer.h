@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+namespace SimplePlot::Render {
+	// Pixels are stored top-down as 0xAARRGGBB, the layout of a 32 bit DIB, so a framebuffer can be
+	// handed to GDI or an encoder without conversion.
+	typedef uint32_t Pixel;
+
+	inline Pixel pixelFromColorRef(unsigned long colorRef) {
+		return 0xff000000u | ((colorRef & 0xff) << 16) | (colorRef & 0xff00) | ((colorRef >> 16) & 0xff);
+	}
+
+	// Blends src over dst with coverage a in [0, 255]. The result is opaque.
+	inline Pixel blendPixel(Pixel dst, Pixel src, unsigned int a) {
+		unsigned int ia = 255 - a;
+		unsigned int r = (((src >> 16) & 0xff) * a + ((dst >> 16) & 0xff) * ia + 127) / 255;
+		unsigned int g = (((src >> 8) & 0xff) * a + ((dst >> 8) & 0xff) * ia + 127) / 255;
+		unsigned int b = ((src & 0xff) * a + (dst & 0xff) * ia + 127) / 255;
+		return 0xff000000u | (r << 16) | (g << 8) | b;
+	}
+
+	class Framebuffer {
+	public:
+		Framebuffer(int width, int height);
+
+		void clear(Pixel color);
+		Pixel* row(int y) { return pixels.data() + (size_t)y * width; }
+		Pixel const* row(int y) const { return pixels.data() + (size_t)y * width; }
+
+		int width;
+		int height;
+		std::vector<Pixel> pixels;
+	};
+}
\ No newline at end of file
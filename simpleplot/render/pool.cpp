@@ -0,0 +1,134 @@
+#include "pool.h"
+#include <exception>
+
+
+namespace SimplePlot::Render {
+	Pool::Pool(int numThreads) {
+		if (numThreads <= 0) {
+			numThreads = (int)std::thread::hardware_concurrency();
+			if (numThreads <= 0) { numThreads = 1; }
+		}
+		// One queue per worker plus one for callers of parallelFor.
+		for (int i = 0; i <= numThreads; i++) {
+			queues.push_back(std::make_unique<Queue>());
+		}
+		for (int i = 0; i < numThreads; i++) {
+			threads.emplace_back(&Pool::workerLoop, this, i);
+		}
+	}
+
+	Pool::~Pool() {
+		{
+			std::lock_guard<std::mutex> guard(wakeMutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (std::thread& t : threads) {
+			t.join();
+		}
+	}
+
+	int Pool::size() const {
+		return (int)threads.size();
+	}
+
+	bool Pool::popTask(int index, Task& task) {
+		// Take from the front of our own queue, then steal from the back of the others.
+		int numQueues = (int)queues.size();
+		for (int i = 0; i < numQueues; i++) {
+			Queue& q = *queues[(index + i) % numQueues];
+			std::lock_guard<std::mutex> guard(q.mutex);
+			if (q.tasks.empty()) { continue; }
+			if (i == 0) {
+				task = std::move(q.tasks.front());
+				q.tasks.pop_front();
+			}
+			else {
+				task = std::move(q.tasks.back());
+				q.tasks.pop_back();
+			}
+			queued--;
+			return true;
+		}
+		return false;
+	}
+
+	void Pool::workerLoop(int index) {
+		Task task;
+		while (true) {
+			if (popTask(index, task)) {
+				task();
+				task = nullptr;
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(wakeMutex);
+			wake.wait(lock, [this] { return stopping || queued > 0; });
+			if (stopping && queued == 0) { return; }
+		}
+	}
+
+	void Pool::parallelFor(int count, std::function<void(int)> const& task) {
+		if (count <= 0) { return; }
+		if (count == 1 || threads.empty()) {
+			for (int i = 0; i < count; i++) {
+				task(i);
+			}
+			return;
+		}
+
+		struct Batch {
+			std::atomic<int> remaining;
+			std::mutex mutex;
+			std::condition_variable done;
+			std::exception_ptr error;
+		};
+		auto batch = std::make_shared<Batch>();
+		batch->remaining = count;
+
+		// Deal the indices out round-robin so every worker starts with local work.
+		int numQueues = (int)queues.size();
+		int first = (int)(nextQueue++ % (unsigned int)numQueues);
+		for (int i = 0; i < count; i++) {
+			Queue& q = *queues[(first + i) % numQueues];
+			std::lock_guard<std::mutex> guard(q.mutex);
+			q.tasks.push_back([batch, &task, i] {
+				try {
+					task(i);
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> g(batch->mutex);
+					if (!batch->error) { batch->error = std::current_exception(); }
+				}
+				if (--batch->remaining == 0) {
+					std::lock_guard<std::mutex> g(batch->mutex);
+					batch->done.notify_all();
+				}
+			});
+			queued++;
+		}
+		{
+			std::lock_guard<std::mutex> guard(wakeMutex);
+		}
+		wake.notify_all();
+
+		// Help out until our batch is finished.
+		Task t;
+		while (batch->remaining > 0) {
+			if (popTask(numQueues - 1, t)) {
+				t();
+				t = nullptr;
+				continue;
+			}
+			std::unique_lock<std::mutex> lock(batch->mutex);
+			batch->done.wait(lock, [&batch] { return batch->remaining == 0; });
+		}
+		if (batch->error) {
+			std::rethrow_exception(batch->error);
+		}
+	}
+
+	Pool& getPool() {
+		static Pool pool;
+		return pool;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace SimplePlot::Render {
+	class Pool {
+	public:
+		Pool(int numThreads = 0);
+		~Pool();
+		Pool(const Pool&) = delete;
+		Pool& operator=(Pool const&) = delete;
+
+		// Runs task(0) ... task(count - 1) and returns once all of them have finished. The calling thread
+		// helps execute tasks, so it is safe to call parallelFor from inside another task. The first
+		// exception thrown by a task is rethrown here.
+		void parallelFor(int count, std::function<void(int)> const& task);
+		int size() const;
+
+	private:
+		typedef std::function<void()> Task;
+		struct Queue {
+			std::mutex mutex;
+			std::deque<Task> tasks;
+		};
+
+		void workerLoop(int index);
+		bool popTask(int index, Task& task);
+
+		std::vector<std::unique_ptr<Queue>> queues;
+		std::vector<std::thread> threads;
+		std::atomic<int> queued = 0;
+		std::atomic<unsigned int> nextQueue = 0;
+		std::mutex wakeMutex;
+		std::condition_variable wake;
+		bool stopping = false;
+	};
+
+	// The process-wide pool, sized to the number of hardware threads.
+	Pool& getPool();
+}
\ No newline at end of file
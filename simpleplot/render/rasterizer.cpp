@@ -0,0 +1,255 @@
+#include "rasterizer.h"
+#pragma warning(disable:4244)
+
+#include "aaline.h"
+#include "pool.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace SimplePlot::Render {
+	namespace {
+		struct Clip {
+			int left, top, right, bottom;// Half open
+		};
+
+		inline int roundPixel(float v) {
+			// Clamp so that points far off the canvas cannot overflow an int.
+			v = (std::max)((std::min)(v, 1e9f), -1e9f);
+			return (int)std::floor(v + 0.5f);
+		}
+
+		void fillRect(Framebuffer& fb, Clip const& clip, float const* p, Pixel color) {
+			int left = (std::max)(roundPixel((std::min)(p[0], p[2])), clip.left);
+			int right = (std::min)(roundPixel((std::max)(p[0], p[2])), clip.right);
+			int top = (std::max)(roundPixel((std::min)(p[1], p[3])), clip.top);
+			int bottom = (std::min)(roundPixel((std::max)(p[1], p[3])), clip.bottom);
+			for (int y = top; y < bottom; y++) {
+				Pixel* row = fb.row(y);
+				for (int x = left; x < right; x++) {
+					row[x] = color;
+				}
+			}
+		}
+
+		void drawImage(Framebuffer& fb, Clip const& clip, Image const& image) {
+			int left = (std::max)(image.left, clip.left);
+			int right = (std::min)(image.left + image.width, clip.right);
+			int top = (std::max)(image.top, clip.top);
+			int bottom = (std::min)(image.top + image.height, clip.bottom);
+			for (int y = top; y < bottom; y++) {
+				Pixel* dst = fb.row(y);
+				Pixel const* src = image.pixels.data() + (size_t)(y - image.top) * image.width - image.left;
+				for (int x = left; x < right; x++) {
+					unsigned int a = src[x] >> 24;
+					if (a == 0) { continue; }
+					dst[x] = a == 255 ? src[x] : blendPixel(dst[x], src[x], a);
+				}
+			}
+		}
+
+		void drawMask(Framebuffer& fb, Clip const& clip, float const* p, Mask const& mask, Pixel color) {
+			int maskLeft = (int)p[0];
+			int maskTop = (int)p[1];
+			int left = (std::max)(maskLeft, clip.left);
+			int right = (std::min)(maskLeft + mask.width, clip.right);
+			int top = (std::max)(maskTop, clip.top);
+			int bottom = (std::min)(maskTop + mask.height, clip.bottom);
+			for (int y = top; y < bottom; y++) {
+				Pixel* dst = fb.row(y);
+				uint8_t const* src = mask.coverage.data() + (size_t)(y - maskTop) * mask.width - maskLeft;
+				for (int x = left; x < right; x++) {
+					unsigned int a = src[x];
+					if (a == 0) { continue; }
+					dst[x] = a == 255 ? color : blendPixel(dst[x], color, a);
+				}
+			}
+		}
+
+		void drawSegment(Framebuffer& fb, Clip const& clip, float x0, float y0, float x1, float y1, int width, Pixel color) {
+			// Every pixel is derived from the segment end points alone (never from a running error
+			// term), so clipping to a tile cannot change which pixels are set.
+			float dx = x1 - x0;
+			float dy = y1 - y0;
+			int below = (width - 1) / 2;
+			if (std::fabs(dx) >= std::fabs(dy)) {
+				if (x1 < x0) { std::swap(x0, x1); std::swap(y0, y1); dx = -dx; dy = -dy; }
+				float slope = dx == 0 ? 0 : dy / dx;
+				int begin = (std::max)(roundPixel(x0), clip.left);
+				int end = (std::min)(roundPixel(x1), clip.right - 1);
+				for (int x = begin; x <= end; x++) {
+					int y = roundPixel(y0 + (x - x0) * slope) - below;
+					int yBegin = (std::max)(y, clip.top);
+					int yEnd = (std::min)(y + width, clip.bottom);
+					for (int yy = yBegin; yy < yEnd; yy++) {
+						fb.row(yy)[x] = color;
+					}
+				}
+			}
+			else {
+				if (y1 < y0) { std::swap(x0, x1); std::swap(y0, y1); dx = -dx; dy = -dy; }
+				float slope = dx / dy;
+				int begin = (std::max)(roundPixel(y0), clip.top);
+				int end = (std::min)(roundPixel(y1), clip.bottom - 1);
+				for (int y = begin; y <= end; y++) {
+					int x = roundPixel(x0 + (y - y0) * slope) - below;
+					int xBegin = (std::max)(x, clip.left);
+					int xEnd = (std::min)(x + width, clip.right);
+					Pixel* row = fb.row(y);
+					for (int xx = xBegin; xx < xEnd; xx++) {
+						row[xx] = color;
+					}
+				}
+			}
+		}
+	}
+
+	Rasterizer::Rasterizer(int tileSize, bool antialias) : tileSize(tileSize), antialias(antialias) {}
+
+	void Rasterizer::addToBins(int primitive, int segment, float minX, float minY, float maxX, float maxY, int width, int height) {
+		if (!(maxX >= 0 && maxY >= 0 && minX < width && minY < height)) { return; }
+		int tx0 = (int)(std::max)(minX, 0.0f) / tileSize;
+		int ty0 = (int)(std::max)(minY, 0.0f) / tileSize;
+		int tx1 = (int)(std::min)(maxX, width - 1.0f) / tileSize;
+		int ty1 = (int)(std::min)(maxY, height - 1.0f) / tileSize;
+		for (int ty = ty0; ty <= ty1; ty++) {
+			for (int tx = tx0; tx <= tx1; tx++) {
+				bins[ty * tilesX + tx].push_back({ primitive, segment });
+			}
+		}
+	}
+
+	void Rasterizer::addSegmentToBins(int primitive, int segment, float const* p, float pad, int width, int height) {
+		float x0 = p[0], y0 = p[1], x1 = p[2], y1 = p[3];
+		float minX = (std::min)(x0, x1), maxX = (std::max)(x0, x1);
+		float minY = (std::min)(y0, y1), maxY = (std::max)(y0, y1);
+		if (maxX - minX <= tileSize && maxY - minY <= tileSize) {
+			addToBins(primitive, segment, minX - pad, minY - pad, maxX + pad, maxY + pad, width, height);
+			return;
+		}
+
+		// Long segments: walk the tile columns (or rows) along the major axis and only bin the tiles
+		// near the segment instead of its whole bounding box.
+		bool xMajor = maxX - minX >= maxY - minY;
+		if (!xMajor) {
+			std::swap(x0, y0);
+			std::swap(x1, y1);
+			std::swap(width, height);
+		}
+		if (x1 < x0) {
+			std::swap(x0, x1);
+			std::swap(y0, y1);
+		}
+		float slope = (y1 - y0) / (x1 - x0);
+		float begin = (std::max)(x0 - pad, 0.0f);
+		float end = (std::min)(x1 + pad, width - 1.0f);
+		for (float start = begin; start <= end; start = (std::floor(start / tileSize) + 1) * tileSize) {
+			float stop = (std::min)((std::floor(start / tileSize) + 1) * tileSize, end);
+			float ya = y0 + ((std::min)((std::max)(start, x0), x1) - x0) * slope;
+			float yb = y0 + ((std::min)((std::max)(stop, x0), x1) - x0) * slope;
+			if (xMajor) {
+				addToBins(primitive, segment, start, (std::min)(ya, yb) - pad, stop, (std::max)(ya, yb) + pad, width, height);
+			}
+			else {
+				addToBins(primitive, segment, (std::min)(ya, yb) - pad, start, (std::max)(ya, yb) + pad, stop, height, width);
+			}
+		}
+	}
+
+	void Rasterizer::bin(DrawList const& list, int width, int height) {
+		tilesX = (width + tileSize - 1) / tileSize;
+		tilesY = (height + tileSize - 1) / tileSize;
+		bins.resize(tilesX * tilesY);
+		for (std::vector<BinEntry>& b : bins) {
+			b.clear();
+		}
+
+		for (int i = 0; i < (int)list.primitives.size(); i++) {
+			Primitive const& prim = list.primitives[i];
+			float const* p = list.points.data() + prim.first * 2;
+			switch (prim.type) {
+			case PRIMITIVE::RECT:
+			case PRIMITIVE::IMAGE:
+			case PRIMITIVE::MASK:
+				addToBins(i, 0, (std::min)(p[0], p[2]) - 1, (std::min)(p[1], p[3]) - 1, (std::max)(p[0], p[2]) + 1, (std::max)(p[1], p[3]) + 1, width, height);
+				break;
+			case PRIMITIVE::POLYLINE: {
+				// Pad by the pen width and the half pixel lost to rounding.
+				float pad = prim.width + 1.0f;
+				for (int s = 0; s < prim.count - 1; s++) {
+					addSegmentToBins(i, s, p + s * 2, pad, width, height);
+				}
+				break;
+			}
+			}
+		}
+	}
+
+	void Rasterizer::rasterizeTile(int tile, DrawList const& list, Framebuffer& fb) const {
+		int tx = tile % tilesX;
+		int ty = tile / tilesX;
+		Clip clip = { tx * tileSize, ty * tileSize, (std::min)((tx + 1) * tileSize, fb.width), (std::min)((ty + 1) * tileSize, fb.height) };
+
+		thread_local CoverageMask mask;
+		thread_local std::vector<Segment> batch;
+		if (antialias) {
+			mask.reset(clip.left, clip.top, clip.right - clip.left, clip.bottom - clip.top);
+		}
+
+		std::vector<BinEntry> const& entries = bins[tile];
+		for (size_t e = 0; e < entries.size(); e++) {
+			Primitive const& prim = list.primitives[entries[e].primitive];
+			float const* p = list.points.data() + (prim.first + entries[e].segment) * 2;
+			switch (prim.type) {
+			case PRIMITIVE::RECT:
+				fillRect(fb, clip, p, prim.color);
+				break;
+			case PRIMITIVE::IMAGE:
+				drawImage(fb, clip, list.images[prim.image]);
+				break;
+			case PRIMITIVE::MASK:
+				drawMask(fb, clip, p, *list.masks[prim.image], prim.color);
+				break;
+			case PRIMITIVE::POLYLINE:
+				if (!antialias) {
+					drawSegment(fb, clip, p[0], p[1], p[2], p[3], prim.width, prim.color);
+					break;
+				}
+				// Cover the whole run of this polyline's segments before blending, so that its joints
+				// are only blended once.
+				batch.clear();
+				for (int primitive = entries[e].primitive; e < entries.size() && entries[e].primitive == primitive; e++) {
+					float const* q = list.points.data() + (prim.first + entries[e].segment) * 2;
+					batch.push_back({ q[0], q[1], q[2], q[3] });
+				}
+				e--;
+				coverSegments(mask, batch.data(), (int)batch.size(), (float)prim.width);
+				blendCoverage(fb, mask, prim.color);
+				mask.clear();
+				break;
+			}
+		}
+	}
+
+	long long Rasterizer::bytes() const {
+		long long total = (long long)(bins.capacity() * sizeof(bins[0]));
+		for (std::vector<BinEntry> const& tile : bins) {
+			total += (long long)(tile.capacity() * sizeof(BinEntry));
+		}
+		return total;
+	}
+
+	void Rasterizer::rasterize(DrawList const& list, Framebuffer& fb, bool parallel) {
+		bin(list, fb.width, fb.height);
+		int numTiles = tilesX * tilesY;
+		if (parallel) {
+			getPool().parallelFor(numTiles, [this, &list, &fb](int tile) { rasterizeTile(tile, list, fb); });
+		}
+		else {
+			for (int tile = 0; tile < numTiles; tile++) {
+				rasterizeTile(tile, list, fb);
+			}
+		}
+	}
+}
\ No newline at end of file
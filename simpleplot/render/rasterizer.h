@@ -0,0 +1,38 @@
+#pragma once
+#include <vector>
+
+#include "../standard.h"
+#include "drawlist.h"
+#include "framebuffer.h"
+
+
+namespace SimplePlot::Render {
+	// Software rasterizer for draw lists. The framebuffer is split into square tiles, every primitive is
+	// binned into the tiles its bounds overlap, and the tiles are then rasterized independently. Each
+	// pixel's value depends only on the primitives covering it, in draw-list order, so the parallel and
+	// serial results are byte-identical.
+	class Rasterizer {
+	public:
+		Rasterizer(int tileSize = SP_TILE_SIZE, bool antialias = true);
+
+		void rasterize(DrawList const& list, Framebuffer& fb, bool parallel = true);
+		long long bytes() const;// Bins kept between frames
+
+	private:
+		struct BinEntry {
+			int primitive;
+			int segment;
+		};
+
+		void bin(DrawList const& list, int width, int height);
+		void addToBins(int primitive, int segment, float minX, float minY, float maxX, float maxY, int width, int height);
+		void addSegmentToBins(int primitive, int segment, float const* p, float pad, int width, int height);
+		void rasterizeTile(int tile, DrawList const& list, Framebuffer& fb) const;
+
+		int tileSize;
+		bool antialias;
+		int tilesX = 0;
+		int tilesY = 0;
+		std::vector<std::vector<BinEntry>> bins;
+	};
+}
\ No newline at end of file
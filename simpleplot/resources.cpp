@@ -0,0 +1,111 @@
+#include "resources.h"
+
+#include <map>
+#include <mutex>
+#include <tuple>
+
+
+namespace SimplePlot::Resources {
+	namespace {
+		enum class KIND {
+			PEN,
+			BRUSH,
+			FONT,
+		};
+
+		struct Key {
+			KIND kind;
+			COLORREF color;
+			int width;
+			int style;
+			std::wstring face;
+			int size;
+			int escapement;
+
+			bool operator<(Key const& other) const {
+				return std::tie(kind, color, width, style, face, size, escapement) <
+					std::tie(other.kind, other.color, other.width, other.style, other.face, other.size, other.escapement);
+			}
+		};
+
+		struct Entry {
+			HGDIOBJ object;
+			int refs;
+		};
+
+		std::mutex cacheMutex;
+		std::map<Key, Entry> cache;
+		std::map<HGDIOBJ, std::map<Key, Entry>::iterator> handles;
+		long long createdCount = 0;
+		long long reusedCount = 0;
+
+		HGDIOBJ create(Key const& key) {
+			switch (key.kind) {
+			case KIND::PEN:
+				return CreatePen(key.style, key.width, key.color);
+			case KIND::BRUSH:
+				return CreateSolidBrush(key.color);
+			case KIND::FONT:
+			default:
+				// For fonts, style holds the weight.
+				return CreateFont(key.size, 0, key.escapement, key.escapement, key.style, FALSE, FALSE, FALSE, ANSI_CHARSET,
+					OUT_DEFAULT_PRECIS, CLIP_DEFAULT_PRECIS, ANTIALIASED_QUALITY, DEFAULT_PITCH | FF_DONTCARE, key.face.c_str());
+			}
+		}
+
+		HGDIOBJ acquire(Key const& key) {
+			std::lock_guard<std::mutex> guard(cacheMutex);
+			auto it = cache.find(key);
+			if (it != cache.end()) {
+				it->second.refs++;
+				reusedCount++;
+				return it->second.object;
+			}
+
+			HGDIOBJ object = create(key);
+			if (object == NULL) { return NULL; }
+			createdCount++;
+			it = cache.emplace(key, Entry{ object, 1 }).first;
+			handles[object] = it;
+			return object;
+		}
+	}
+
+	HPEN acquirePen(int style, int width, COLORREF color) {
+		return (HPEN)acquire({ KIND::PEN, color, width, style, L"", 0, 0 });
+	}
+
+	HBRUSH acquireBrush(COLORREF color) {
+		return (HBRUSH)acquire({ KIND::BRUSH, color, 0, 0, L"", 0, 0 });
+	}
+
+	HFONT acquireFont(std::wstring const& face, int size, int weight, int escapement) {
+		return (HFONT)acquire({ KIND::FONT, 0, 0, weight, face, size, escapement });
+	}
+
+	void retain(HGDIOBJ object) {
+		if (object == NULL) { return; }
+		std::lock_guard<std::mutex> guard(cacheMutex);
+		auto it = handles.find(object);
+		if (it != handles.end()) {
+			it->second->second.refs++;
+		}
+	}
+
+	void release(HGDIOBJ object) {
+		if (object == NULL) { return; }
+		std::lock_guard<std::mutex> guard(cacheMutex);
+		auto it = handles.find(object);
+		if (it == handles.end()) { return; }
+		if (--it->second->second.refs == 0) {
+			DeleteObject(object);
+			cache.erase(it->second);
+			handles.erase(it);
+		}
+	}
+
+	ResourceStats getResourceStats() {
+		std::lock_guard<std::mutex> guard(cacheMutex);
+		return { (int)cache.size(), createdCount, reusedCount };
+	}
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+#include <windows.h>
+#include <string>
+
+
+namespace SimplePlot::Resources {
+	// Pens, brushes and fonts are shared process-wide. Asking for an object that already exists returns the
+	// same handle and bumps its reference count; the object is deleted when the last reference is released.
+	// Handles obtained here must be given back with release, never with DeleteObject.
+	HPEN acquirePen(int style, int width, COLORREF color);
+	HBRUSH acquireBrush(COLORREF color);
+	HFONT acquireFont(std::wstring const& face, int size, int weight, int escapement = 0);
+
+	// Takes an extra reference to a handle that came from one of the acquire functions.
+	void retain(HGDIOBJ object);
+	void release(HGDIOBJ object);
+
+	struct ResourceStats {
+		int live;// Objects currently held by the cache
+		long long created;// GDI objects created since startup
+		long long reused;// Acquisitions satisfied without creating anything
+	};
+	ResourceStats getResourceStats();
+}
\ No newline at end of file
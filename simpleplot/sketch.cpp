@@ -0,0 +1,148 @@
+#include "sketch.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace SimplePlot::Sketch {
+	KllSketch::KllSketch(int k) : k((std::max)(k, 8)) {
+		addLevel();
+	}
+
+	void KllSketch::update(double value) {
+		if (std::isnan(value)) { return; }
+		if (n == 0) {
+			minSeen = maxSeen = value;
+		}
+		else {
+			minSeen = (std::min)(minSeen, value);
+			maxSeen = (std::max)(maxSeen, value);
+		}
+		levels[0].push_back(value);
+		n++;
+		retained++;
+		viewValid = false;
+		compress();
+	}
+
+	void KllSketch::merge(KllSketch const& other) {
+		if (other.n == 0) { return; }
+		if (n == 0) {
+			minSeen = other.minSeen;
+			maxSeen = other.maxSeen;
+		}
+		else {
+			minSeen = (std::min)(minSeen, other.minSeen);
+			maxSeen = (std::max)(maxSeen, other.maxSeen);
+		}
+		while (levels.size() < other.levels.size()) {
+			addLevel();
+		}
+		for (size_t h = 0; h < other.levels.size(); h++) {
+			levels[h].insert(levels[h].end(), other.levels[h].begin(), other.levels[h].end());
+			retained += (int)other.levels[h].size();
+		}
+		n += other.n;
+		viewValid = false;
+		compress();
+	}
+
+	void KllSketch::clear() {
+		n = 0;
+		retained = 0;
+		levels.clear();
+		addLevel();
+		viewValid = false;
+	}
+
+	long long KllSketch::bytes() const {
+		long long total = (long long)(levels.capacity() * sizeof(std::vector<double>) + capacities.capacity() * sizeof(int) +
+			view.capacity() * sizeof(view[0]));
+		for (std::vector<double> const& level : levels) {
+			total += (long long)(level.capacity() * sizeof(double));
+		}
+		return total;
+	}
+
+	void KllSketch::addLevel() {
+		// Capacities shrink geometrically by 2/3 going down from the top level, which gets k, so they all
+		// change when a level is added. Nothing goes below 8, which keeps compactions of the bottom level rare.
+		levels.emplace_back();
+		capacities.resize(levels.size());
+		totalCapacity = 0;
+		for (size_t h = 0; h < levels.size(); h++) {
+			int depth = (int)(levels.size() - 1 - h);
+			capacities[h] = (std::max)(8, (int)std::ceil(k * std::pow(2.0 / 3.0, depth)));
+			totalCapacity += capacities[h];
+		}
+	}
+
+	void KllSketch::compress() {
+		// Compact the lowest over-full level until the whole sketch fits: sort it, keep every other item
+		// starting at a random one of the first two, and promote the survivors to double weight.
+		while (retained > totalCapacity) {
+			size_t h = 0;
+			while (h < levels.size() && (int)levels[h].size() < capacities[h]) {
+				h++;
+			}
+			if (h == levels.size()) { return; }
+			if (h + 1 == levels.size()) {
+				addLevel();
+			}
+
+			std::vector<double>& level = levels[h];
+			std::sort(level.begin(), level.end());
+			// An odd item out stays behind, so the total weight is unchanged.
+			double leftover = 0;
+			bool hasLeftover = level.size() % 2 == 1;
+			if (hasLeftover) {
+				leftover = level.back();
+				level.pop_back();
+			}
+			randomState ^= randomState << 13;
+			randomState ^= randomState >> 7;
+			randomState ^= randomState << 17;
+			size_t offset = randomState & 1;
+			std::vector<double>& above = levels[h + 1];
+			for (size_t i = offset; i < level.size(); i += 2) {
+				above.push_back(level[i]);
+			}
+			retained -= (int)(level.size() / 2);
+			level.clear();
+			if (hasLeftover) {
+				level.push_back(leftover);
+			}
+		}
+	}
+
+	void KllSketch::sortView() const {
+		view.clear();
+		for (size_t h = 0; h < levels.size(); h++) {
+			for (double value : levels[h]) {
+				view.push_back({ value, 1LL << h });
+			}
+		}
+		std::sort(view.begin(), view.end());
+		long long cumulative = 0;
+		for (std::pair<double, long long>& item : view) {
+			cumulative += item.second;
+			item.second = cumulative;
+		}
+		viewValid = true;
+	}
+
+	double KllSketch::quantile(double fraction) const {
+		if (n == 0) { return 0; }
+		if (fraction <= 0) { return minSeen; }
+		if (fraction >= 1) { return maxSeen; }
+		if (!viewValid) {
+			sortView();
+		}
+		long long total = view.back().second;
+		double rank = fraction * total;
+		auto it = std::lower_bound(view.begin(), view.end(), rank, [](std::pair<double, long long> const& item, double r) {
+			return item.second < r;
+		});
+		return it == view.end() ? maxSeen : it->first;
+	}
+}
\ No newline at end of file
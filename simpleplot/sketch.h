@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+
+#include "standard.h"
+
+
+namespace SimplePlot::Sketch {
+	// A KLL quantile sketch (Karnin, Lang and Liberty, 2016). It holds about 3k values however many it is
+	// fed, and answers rank queries to within roughly 1.7 / k of the total count. Sketches of different data
+	// merge into a sketch of the union, and the extremes are kept exactly.
+	class KllSketch {
+	public:
+		explicit KllSketch(int k = SP_SKETCH_K);
+
+		void update(double value);// NaNs are ignored
+		void merge(KllSketch const& other);
+		void clear();
+		long long bytes() const;// Heap memory held
+
+		double quantile(double fraction) const;// fraction in [0, 1]; 0 and 1 give the exact extremes
+		long long count() const { return n; }
+		double minValue() const { return minSeen; }
+		double maxValue() const { return maxSeen; }
+
+	private:
+		void addLevel();
+		void compress();
+		void sortView() const;
+
+		int k;
+		long long n = 0;
+		double minSeen = 0;
+		double maxSeen = 0;
+		int retained = 0;
+		std::vector<std::vector<double>> levels;// An item at level h stands for 2^h of the input
+		std::vector<int> capacities;// Per level
+		int totalCapacity = 0;
+		unsigned long long randomState = 0x9E3779B97F4A7C15ULL;
+
+		mutable bool viewValid = false;
+		mutable std::vector<std::pair<double, long long>> view;// (value, cumulative weight), sorted by value
+	};
+}
\ No newline at end of file
@@ -9,15 +9,38 @@
 #define SP_TICK_LENGTH 6
 #define SP_NULL_PLOT -1
 #define SP_NULL_CANVAS -1
+#define SP_NULL_LINK -1
 #define SP_X_AXIS 0
 #define SP_Y_AXIS 1
 #define SP_Z_AXIS 2
 #define SP_MAX_ASPECT 5
+#define SP_TILE_SIZE 64
+#define SP_TEXT_CACHE_SIZE 4096
+#define SP_MIN_TICK_SPACING 100
+#define SP_MIN_MINOR_TICK_SPACING 10
+#define SP_FORMAT_BUFFER_SIZE 40
+#define SP_MAX_TIME_OFFSET 4503599627370496.0// 2^52 ns (52 days): how far a time axis may stray from its origin
+#define SP_SKETCH_K 1000
+#define SP_DEFLATE_LEVEL 6
+#define SP_DEFLATE_CHUNK 131072// Bytes of input per independently compressed chunk
+#define SP_PNG_IDAT_SIZE 65536
+#define SP_RECORDING_QUEUE 8// Frames waiting for the encoder before new ones are dropped
+#define SP_PROFILE_FRAMES 256
+#define SP_PROFILE_MAX_PLOTS 16
+#define SP_TRACE_FLUSH_MS 100
+#define SP_TRACE_NO_ID -1
+#define SP_FRAMERATE_BUDGET -1.0// A frame budget of 1000 / framerate milliseconds
+#define SP_DETAIL_DENSITY 5// The coarsest level of detail, at which dense lines are shaded by density instead of drawn
+#define SP_DETAIL_DENSE 4// Points per pixel column from which a line counts as dense
+#define SP_DETAIL_HEADROOM 0.5// Fraction of the frame budget under which frames count towards finer detail
+#define SP_DETAIL_SETTLE 10// Frames in a row with headroom before detail is refined
+#define SP_SVG_TOLERANCE 0.25f// Pixels of the target size that simplified polylines may stray
 
 
 namespace SimplePlot {
 	typedef int PLOT_ID;
 	typedef int CANVAS_ID;
+	typedef int LINK_ID;
 
 	enum class PLOT_TYPE {
 		// Ordered in terms of depth: the lowest numbers are drawn first.
@@ -25,6 +48,41 @@ namespace SimplePlot {
 		LINE,
 		SERIES,
 		HISTOGRAM,
+		SCATTER,
+	};
+
+	enum class NORMALIZATION {
+		// How accumulated densities are mapped onto a colour scale.
+		LINEAR,
+		LOG,
+		EQUALIZE,
+	};
+
+	enum class NUMBER_FORMAT {
+		AUTO,// FIXED, or SCIENTIFIC for very large or small numbers
+		FIXED,// 1234.5
+		SCIENTIFIC,// 1.2345e3
+		ENGINEERING,// 1.2345e3, with the exponent a multiple of 3
+		SI,// 1.2345k
+		SHORTEST,// The fewest digits that read back as the same double
+	};
+
+	enum class EXPORT_FORMAT {
+		PNG,
+		SVG,
+	};
+
+	enum class RECORDING_FORMAT {
+		RAW,// Frames of 8 bit RGBA, back to back, with no header
+		Y4M,// YUV4MPEG2, 4:2:0
+		APNG,// Animated PNG
+	};
+
+	enum class MEMORY_CATEGORY {
+		DATA,
+		CACHES,
+		BITMAPS,
+		SCRATCH,
 	};
 
 	enum class AXIS_TYPE {
@@ -17,6 +17,7 @@ namespace SimplePlot::Stats {
 	template float minValue<float>(float* p, int size);
 	template double minValue<double>(double* p, int size);
 	template int minValue<int>(int* p, int size);
+	template long long minValue<long long>(long long* p, int size);
 
 
 	template<typename T>
@@ -34,36 +35,28 @@ namespace SimplePlot::Stats {
 	template float maxValue<float>(float* p, int size);
 	template double maxValue<double>(double* p, int size);
 	template int maxValue<int>(int* p, int size);
+	template long long maxValue<long long>(long long* p, int size);
 
 
 	template<typename T>
 	int binFindLeft(T* v, int size, T data, int start) {
-		// Find the left point of an interval in v that contains data.
-		if (size == 1) {
-			if (v[0] <= data) {
-				return start;
+		// Find the left point of an interval in v that contains data: the last entry that is <= data, offset by
+		// start. Data past the last entry falls in the last interval.
+		if (size < 1 || data < v[0]) {
+			throw std::invalid_argument("List was too small");
+		}
+		int low = 0;
+		int high = size - 1;
+		while (low < high) {
+			int middle = low + (high - low + 1) / 2;
+			if (v[middle] <= data) {
+				low = middle;
 			}
 			else {
-				if (start > 0) {
-					return start - 1;
-				}
-				else {
-					std::invalid_argument("List was too small");
-				}
+				high = middle - 1;
 			}
 		}
-
-		if (v[size / 2] == data) {
-			return size / 2;
-		}
-		else if (v[size / 2] < data) {
-			// Search right
-			return binFindLeft(v, size - (size / 2 + 1), data, start + size / 2 + 1);
-		}
-		else {
-			// Search left
-			return binFindLeft(v, size / 2, data, start);
-		}
+		return start + low;
 	}
 
 	template int binFindLeft<float>(float* v, int size, float data, int start);
@@ -72,14 +65,30 @@ namespace SimplePlot::Stats {
 
 
 	template<typename T>
-	std::wstring round(T f, int numDigs) {
-		if (f == 0) { return L"0"; }
-		int length = (int)log10(abs(f)) + 1 + numDigs;
-		if (f < 0) { length++; }
-		return std::to_wstring(f).substr(0, length);
+	void countUniformBins(T const* data, int size, T minBin, T maxBin, int numBins, int* counts) {
+		for (int i = 0; i < size; i++) {
+			int index = int((data[i] - minBin) / (maxBin - minBin) * numBins * (numBins / (numBins + 1.0f)));
+			// The final term is to make the second bound inclusive
+
+			if (index < 0 || index >= numBins) { continue; }
+			counts[index]++;
+		}
+	}
+
+	template void countUniformBins<float>(float const* data, int size, float minBin, float maxBin, int numBins, int* counts);
+	template void countUniformBins<double>(double const* data, int size, double minBin, double maxBin, int numBins, int* counts);
+	template void countUniformBins<int>(int const* data, int size, int minBin, int maxBin, int numBins, int* counts);
+
+
+	template<typename T>
+	void countCustomBins(T const* data, int size, T* leftBins, int numBins, int* counts) {
+		for (int i = 0; i < size; i++) {
+			if (data[i] < leftBins[0]) { continue; }
+			counts[binFindLeft<T>(leftBins, numBins, data[i])]++;
+		}
 	}
 
-	template std::wstring round<float>(float f, int numDigs);
-	template std::wstring round<double>(double f, int numDigs);
-	template std::wstring round<int>(int f, int numDigs);
+	template void countCustomBins<float>(float const* data, int size, float* leftBins, int numBins, int* counts);
+	template void countCustomBins<double>(double const* data, int size, double* leftBins, int numBins, int* counts);
+	template void countCustomBins<int>(int const* data, int size, int* leftBins, int numBins, int* counts);
 }
\ No newline at end of file
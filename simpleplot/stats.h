@@ -1,5 +1,4 @@
 #pragma once
-#include <string>
 
 namespace SimplePlot::Stats {
 	template<typename T>
@@ -11,6 +10,12 @@ namespace SimplePlot::Stats {
 	template<typename T>
 	int binFindLeft(T* v, int size, T data, int start = 0);
 
+	// Adds each value's bin to counts, for numBins equal bins from minBin to maxBin inclusive. Values outside
+	// are skipped.
 	template<typename T>
-	std::wstring round(T f, int numDigs);
+	void countUniformBins(T const* data, int size, T minBin, T maxBin, int numBins, int* counts);
+
+	// As countUniformBins, with bins starting at the sorted leftBins. Values below the first bin are skipped.
+	template<typename T>
+	void countCustomBins(T const* data, int size, T* leftBins, int numBins, int* counts);
 }
\ No newline at end of file
@@ -0,0 +1,151 @@
+#include "text.h"
+#include "standard.h"
+#include "resources.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <list>
+#include <map>
+#include <mutex>
+#include <utility>
+
+
+namespace SimplePlot::Text {
+	namespace {
+		typedef std::pair<HFONT, std::wstring> Key;
+
+		struct Entry {
+			SIZE extent;
+			std::shared_ptr<Render::Mask const> masks[4];// One per quarter turn, rendered on demand
+			std::list<Key>::iterator age;
+		};
+
+		std::mutex textMutex;
+		std::map<Key, Entry> cache;
+		std::list<Key> ages;// Most recently used first
+		HDC measureDC = NULL;
+		long long hitCount = 0;
+		long long missCount = 0;
+
+		HDC getDC() {
+			if (measureDC == NULL) {
+				measureDC = CreateCompatibleDC(NULL);
+			}
+			return measureDC;
+		}
+
+		// Must be called with textMutex held.
+		Entry& lookup(std::wstring const& text, HFONT font) {
+			Key key(font, text);
+			auto it = cache.find(key);
+			if (it != cache.end()) {
+				hitCount++;
+				ages.splice(ages.begin(), ages, it->second.age);
+				return it->second;
+			}
+			missCount++;
+
+			if (cache.size() >= SP_TEXT_CACHE_SIZE) {
+				auto oldest = cache.find(ages.back());
+				Resources::release(oldest->first.first);
+				cache.erase(oldest);
+				ages.pop_back();
+			}
+
+			// Hold a reference so the handle can't be deleted and reused for a different font while cached.
+			Resources::retain(font);
+			HDC hdc = getDC();
+			HFONT oldFont = (HFONT)SelectObject(hdc, font);
+			RECT rect = { 0, 0, 0, 0 };
+			DrawText(hdc, text.c_str(), (int)text.size(), &rect, DT_CALCRECT);
+			SelectObject(hdc, oldFont);
+
+			ages.push_front(key);
+			Entry& entry = cache[key];
+			entry.extent = { rect.right - rect.left, rect.bottom - rect.top };
+			entry.age = ages.begin();
+			return entry;
+		}
+
+		std::shared_ptr<Render::Mask const> render(std::wstring const& text, HFONT font, SIZE extent, int quarterTurns) {
+			if (extent.cx <= 0 || extent.cy <= 0) { return nullptr; }
+			HDC hdc = getDC();
+
+			BITMAPINFO bmi = {};
+			bmi.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+			bmi.bmiHeader.biWidth = extent.cx;
+			bmi.bmiHeader.biHeight = -extent.cy;// Top-down
+			bmi.bmiHeader.biPlanes = 1;
+			bmi.bmiHeader.biBitCount = 32;
+			bmi.bmiHeader.biCompression = BI_RGB;
+			void* bits = nullptr;
+			HBITMAP bitmap = CreateDIBSection(hdc, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+			if (!bitmap) { return nullptr; }
+			memset(bits, 0, (size_t)extent.cx * extent.cy * 4);
+
+			// White on black, so any channel of the result is the glyph coverage.
+			HBITMAP oldBitmap = (HBITMAP)SelectObject(hdc, bitmap);
+			HFONT oldFont = (HFONT)SelectObject(hdc, font);
+			SetTextColor(hdc, RGB(255, 255, 255));
+			SetBkMode(hdc, TRANSPARENT);
+			RECT rect = { 0, 0, extent.cx, extent.cy };
+			DrawText(hdc, text.c_str(), (int)text.size(), &rect, DT_LEFT);
+			GdiFlush();
+
+			std::shared_ptr<Render::Mask> mask = std::make_shared<Render::Mask>();
+			bool sideways = quarterTurns % 2 == 1;
+			mask->width = sideways ? extent.cy : extent.cx;
+			mask->height = sideways ? extent.cx : extent.cy;
+			mask->coverage.resize((size_t)extent.cx * extent.cy);
+			uint32_t const* src = (uint32_t const*)bits;
+			for (int y = 0; y < extent.cy; y++) {
+				for (int x = 0; x < extent.cx; x++) {
+					uint32_t p = src[(size_t)y * extent.cx + x];
+					uint8_t c = (uint8_t)(std::max)({ p & 0xff, (p >> 8) & 0xff, (p >> 16) & 0xff });
+					int mx, my;
+					switch (quarterTurns) {
+					default:
+					case 0: mx = x; my = y; break;
+					case 1: mx = y; my = extent.cx - 1 - x; break;// 90 degrees counter-clockwise
+					case 2: mx = extent.cx - 1 - x; my = extent.cy - 1 - y; break;
+					case 3: mx = extent.cy - 1 - y; my = x; break;
+					}
+					mask->coverage[(size_t)my * mask->width + mx] = c;
+				}
+			}
+
+			SelectObject(hdc, oldFont);
+			SelectObject(hdc, oldBitmap);
+			DeleteObject(bitmap);
+			return mask;
+		}
+	}
+
+	SIZE measure(std::wstring const& text, HFONT font) {
+		std::lock_guard<std::mutex> guard(textMutex);
+		return lookup(text, font).extent;
+	}
+
+	std::shared_ptr<Render::Mask const> rasterize(std::wstring const& text, HFONT font, int escapement) {
+		if (text.empty()) { return nullptr; }
+		int quarterTurns = ((int)std::lround(escapement / 900.0) % 4 + 4) % 4;
+		std::lock_guard<std::mutex> guard(textMutex);
+		Entry& entry = lookup(text, font);
+		if (!entry.masks[quarterTurns]) {
+			entry.masks[quarterTurns] = render(text, font, entry.extent, quarterTurns);
+		}
+		return entry.masks[quarterTurns];
+	}
+
+	TextCacheStats getTextCacheStats() {
+		std::lock_guard<std::mutex> guard(textMutex);
+		long long bytes = 0;
+		for (auto const& entry : cache) {
+			for (std::shared_ptr<Render::Mask const> const& mask : entry.second.masks) {
+				if (mask) { bytes += (long long)mask->coverage.capacity(); }
+			}
+		}
+		return { (int)cache.size(), hitCount, missCount, bytes };
+	}
+}
\ No newline at end of file
@@ -0,0 +1,26 @@
+#pragma once
+#include <windows.h>
+#include <memory>
+#include <string>
+
+#include "render/drawlist.h"
+
+
+namespace SimplePlot::Text {
+	// Size of text drawn in font, as DrawText with DT_CALCRECT would report it. Results are cached per
+	// (string, font), so tick numbers and legend entries are only laid out the first time they appear.
+	SIZE measure(std::wstring const& text, HFONT font);
+
+	// Coverage of the text drawn in font, turned by the nearest multiple of 90 degrees to escapement (in
+	// tenths of a degree, counter-clockwise, as in CreateFont). The mask is rendered once and then shared.
+	// Returns null if the text is empty or could not be rendered.
+	std::shared_ptr<Render::Mask const> rasterize(std::wstring const& text, HFONT font, int escapement = 0);
+
+	struct TextCacheStats {
+		int entries;
+		long long hits;
+		long long misses;
+		long long bytes;// Held by rendered masks
+	};
+	TextCacheStats getTextCacheStats();
+}
\ No newline at end of file
@@ -0,0 +1,349 @@
+#include "ticks.h"
+#include "format.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cwchar>
+
+
+namespace SimplePlot::Ticks {
+	namespace {
+		std::wstring makeLabel(double value, NUMBER_FORMAT format, int precision) {
+			wchar_t buffer[SP_FORMAT_BUFFER_SIZE];
+			int length = Format::formatNumber(value, format, precision, buffer, SP_FORMAT_BUFFER_SIZE);
+			return std::wstring(buffer, length);
+		}
+
+		const long long NS_PER_SECOND = 1000000000LL;
+		const long long NS_PER_MINUTE = 60 * NS_PER_SECOND;
+		const long long NS_PER_HOUR = 60 * NS_PER_MINUTE;
+		const long long NS_PER_DAY = 24 * NS_PER_HOUR;
+		const long long EPOCH_TO_MONDAY = 4 * NS_PER_DAY;// 1970-01-01 was a Thursday
+
+		struct TimeStep {
+			long long step;
+			long long minor;// 0 for none
+			long long phase;// Ticks fall on phase + k * step
+		};
+
+		// Steps of a second and more, where round numbers are counted in minutes, hours and days. Shorter
+		// steps follow the 1, 2, 5 pattern.
+		const TimeStep calendarSteps[] = {
+			{ NS_PER_SECOND, NS_PER_SECOND / 5, 0 },
+			{ 2 * NS_PER_SECOND, NS_PER_SECOND / 2, 0 },
+			{ 5 * NS_PER_SECOND, NS_PER_SECOND, 0 },
+			{ 10 * NS_PER_SECOND, 2 * NS_PER_SECOND, 0 },
+			{ 15 * NS_PER_SECOND, 5 * NS_PER_SECOND, 0 },
+			{ 30 * NS_PER_SECOND, 10 * NS_PER_SECOND, 0 },
+			{ NS_PER_MINUTE, 10 * NS_PER_SECOND, 0 },
+			{ 2 * NS_PER_MINUTE, 30 * NS_PER_SECOND, 0 },
+			{ 5 * NS_PER_MINUTE, NS_PER_MINUTE, 0 },
+			{ 10 * NS_PER_MINUTE, 2 * NS_PER_MINUTE, 0 },
+			{ 15 * NS_PER_MINUTE, 5 * NS_PER_MINUTE, 0 },
+			{ 30 * NS_PER_MINUTE, 10 * NS_PER_MINUTE, 0 },
+			{ NS_PER_HOUR, 10 * NS_PER_MINUTE, 0 },
+			{ 2 * NS_PER_HOUR, 30 * NS_PER_MINUTE, 0 },
+			{ 3 * NS_PER_HOUR, NS_PER_HOUR, 0 },
+			{ 6 * NS_PER_HOUR, NS_PER_HOUR, 0 },
+			{ 12 * NS_PER_HOUR, 2 * NS_PER_HOUR, 0 },
+			{ NS_PER_DAY, 6 * NS_PER_HOUR, 0 },
+			{ 2 * NS_PER_DAY, 12 * NS_PER_HOUR, 0 },
+			{ 7 * NS_PER_DAY, NS_PER_DAY, EPOCH_TO_MONDAY },
+			{ 14 * NS_PER_DAY, NS_PER_DAY, EPOCH_TO_MONDAY },
+		};
+
+		long long floorDiv(long long a, long long b) {
+			long long q = a / b;
+			return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+		}
+
+		TimeStep chooseTimeStep(double nsPerPixel, int minSpacing) {
+			double minStep = nsPerPixel * minSpacing;
+			if (minStep <= 1) {
+				return { 1, 0, 0 };
+			}
+			if (minStep < NS_PER_SECOND) {
+				// 1, 2, 5 times a power of ten nanoseconds, with minor ticks on round numbers as in makeLinearTicks
+				for (long long magnitude = 1; magnitude < NS_PER_SECOND; magnitude *= 10) {
+					for (int m : { 1, 2, 5 }) {
+						if (m * magnitude >= minStep) {
+							long long step = m * magnitude;
+							long long minor = m == 2 ? step / 4 : step / 5;
+							return { step, minor > 0 && step % minor == 0 ? minor : 0, 0 };
+						}
+					}
+				}
+			}
+			for (TimeStep const& candidate : calendarSteps) {
+				if (candidate.step >= minStep) {
+					return candidate;
+				}
+			}
+			// Longer than a fortnight: round numbers of days, up to 50000 (about 137 years) so that a step stays
+			// well inside the range of long long
+			double days = (std::min)(minStep / NS_PER_DAY, 50000.0);
+			double magnitude = std::pow(10.0, std::floor(std::log10(days)));
+			for (int m : { 1, 2, 5, 10 }) {
+				if (m * magnitude >= days) {
+					long long step = (long long)(m * magnitude) * NS_PER_DAY;
+					long long minorDays = (long long)(m == 2 ? m * magnitude / 4 : m * magnitude / 5);
+					return { step, minorDays > 0 ? minorDays * NS_PER_DAY : 0, 0 };
+				}
+			}
+			return { 10 * (long long)magnitude * NS_PER_DAY, 0, 0 };
+		}
+
+		// a + b, held to [-limit, limit] instead of overflowing.
+		long long addClamped(long long a, long long b, long long limit) {
+			if (b > 0 && a > limit - b) { return limit; }
+			if (b < 0 && a < -limit - b) { return -limit; }
+			return (std::max)(-limit, (std::min)(a + b, limit));
+		}
+
+		void civilFromDays(long long days, int& year, int& month, int& day) {
+			// Proleptic Gregorian calendar, after Howard Hinnant's days_from_civil inverse.
+			days += 719468;
+			long long era = floorDiv(days, 146097);
+			long long dayOfEra = days - era * 146097;
+			long long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+			long long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+			long long monthIndex = (5 * dayOfYear + 2) / 153;
+			day = int(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+			month = int(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+			year = int(yearOfEra + era * 400 + (month <= 2));
+		}
+
+		std::wstring makeTimeLabel(long long time, long long step) {
+			wchar_t buffer[SP_FORMAT_BUFFER_SIZE];
+			long long days = floorDiv(time, NS_PER_DAY);
+			long long ofDay = time - days * NS_PER_DAY;
+			int hour = int(ofDay / NS_PER_HOUR);
+			int minute = int(ofDay / NS_PER_MINUTE % 60);
+			int second = int(ofDay / NS_PER_SECOND % 60);
+			long long fraction = ofDay % NS_PER_SECOND;
+
+			if (step >= NS_PER_DAY || ofDay == 0) {
+				int year, month, day;
+				civilFromDays(days, year, month, day);
+				swprintf(buffer, SP_FORMAT_BUFFER_SIZE, L"%04d-%02d-%02d", year, month, day);
+			}
+			else if (step >= NS_PER_MINUTE) {
+				swprintf(buffer, SP_FORMAT_BUFFER_SIZE, L"%02d:%02d", hour, minute);
+			}
+			else if (step >= NS_PER_SECOND || fraction == 0) {
+				swprintf(buffer, SP_FORMAT_BUFFER_SIZE, L"%02d:%02d:%02d", hour, minute, second);
+			}
+			else {
+				// Within a second only the seconds and as many fractional digits as the step needs
+				int digits = 9;
+				for (long long s = step; s % 10 == 0; s /= 10) {
+					digits--;
+				}
+				long long scaled = fraction;
+				for (int i = digits; i < 9; i++) {
+					scaled /= 10;
+				}
+				swprintf(buffer, SP_FORMAT_BUFFER_SIZE, L"%02d.%0*lld", second, digits, scaled);
+			}
+			return buffer;
+		}
+	}
+
+	TickSet makeLinearTicks(double minT, double maxT, int pixelLength, NUMBER_FORMAT format, int minSpacing) {
+		TickSet ticks;
+		double range = maxT - minT;
+		if (!std::isfinite(range) || range <= 0 || pixelLength <= 0) {
+			return ticks;
+		}
+
+		int maxTicks = (std::max)(pixelLength / (std::max)(minSpacing, 1), 1);
+		double rawStep = range / maxTicks;
+		double magnitude = std::pow(10.0, std::floor(std::log10(rawStep)));
+		int mantissa = 10;
+		for (int m : { 1, 2, 5 }) {
+			if (m * magnitude >= rawStep) {
+				mantissa = m;
+				break;
+			}
+		}
+		ticks.step = mantissa * magnitude;
+
+		// 1 and 5 split into fifths, 2 into quarters, so that minor ticks also land on round numbers.
+		double pixelsPerUnit = pixelLength / range;
+		int subdivisions = mantissa == 2 ? 4 : 5;
+		if (ticks.step / subdivisions * pixelsPerUnit < SP_MIN_MINOR_TICK_SPACING) {
+			subdivisions = 2;
+		}
+		if (ticks.step / subdivisions * pixelsPerUnit >= SP_MIN_MINOR_TICK_SPACING) {
+			ticks.minorStep = ticks.step / subdivisions;
+		}
+
+		// Positions are integer multiples of the step, so they don't accumulate rounding error.
+		long long first = (long long)std::ceil(minT / ticks.step - 1e-9);
+		long long last = (long long)std::floor(maxT / ticks.step + 1e-9);
+		for (long long i = first; i <= last; i++) {
+			ticks.major.push_back(i * ticks.step);
+		}
+		// One precision for the whole set, so that 0.5, 1.0, 1.5 line up rather than reading 0.5, 1, 1.5. It
+		// comes from the step, since the values themselves can't tell 1.7e9 + 0.1 from rounding noise.
+		format = Format::resolveFormat(ticks.major.data(), (int)ticks.major.size(), format);
+		ticks.precision = Format::stepPrecision(ticks.major.data(), (int)ticks.major.size(), ticks.step, format);
+		for (double value : ticks.major) {
+			ticks.labels.push_back(makeLabel(value, format, ticks.precision));
+		}
+
+		if (ticks.minorStep > 0) {
+			long long firstMinor = (long long)std::ceil(minT / ticks.minorStep - 1e-9);
+			long long lastMinor = (long long)std::floor(maxT / ticks.minorStep + 1e-9);
+			for (long long i = firstMinor; i <= lastMinor; i++) {
+				if (i % subdivisions == 0) { continue; }
+				ticks.minor.push_back(i * ticks.minorStep);
+			}
+		}
+		return ticks;
+	}
+
+	TickSet makeLogTicks(double minLog, double maxLog, int pixelLength, NUMBER_FORMAT format, int minSpacing) {
+		TickSet ticks;
+		double range = maxLog - minLog;
+		if (!std::isfinite(range) || range <= 0 || pixelLength <= 0) {
+			return ticks;
+		}
+		double pixelsPerDecade = pixelLength / range;
+
+		if (std::floor(maxLog) - std::ceil(minLog) < 1) {
+			// Less than two whole decades in view: use round numbers, dropping any that crowd together at the
+			// bottom of the axis.
+			TickSet linear = makeLinearTicks(std::pow(10.0, minLog), std::pow(10.0, maxLog), pixelLength, format, minSpacing);
+			ticks.step = linear.step;
+			ticks.precision = linear.precision;
+			double lastPosition = -HUGE_VAL;
+			for (size_t i = 0; i < linear.major.size(); i++) {
+				if (linear.major[i] <= 0) { continue; }
+				double position = std::log10(linear.major[i]);
+				if ((position - lastPosition) * pixelsPerDecade < minSpacing) { continue; }
+				ticks.major.push_back(position);
+				ticks.labels.push_back(linear.labels[i]);
+				lastPosition = position;
+			}
+			return ticks;
+		}
+
+		// Label every decade, or every 2nd, 5th, 10th, ... decade when they would be too close together.
+		long long decadeStep = 1;
+		for (long long scale = 1; decadeStep * pixelsPerDecade < minSpacing; scale *= 10) {
+			for (long long m : { 1, 2, 5, 10 }) {
+				decadeStep = m * scale;
+				if (decadeStep * pixelsPerDecade >= minSpacing) { break; }
+			}
+		}
+		ticks.step = (double)decadeStep;
+
+		long long first = (long long)std::ceil(minLog / decadeStep - 1e-9);
+		long long last = (long long)std::floor(maxLog / decadeStep + 1e-9);
+		for (long long i = first; i <= last; i++) {
+			ticks.major.push_back((double)(i * decadeStep));
+		}
+		// Each decade gets its own precision; a shared one would print 100.00 next to 0.01.
+		std::vector<double> powers(ticks.major.size());
+		for (size_t i = 0; i < ticks.major.size(); i++) {
+			powers[i] = std::pow(10.0, ticks.major[i]);
+		}
+		format = Format::resolveFormat(powers.data(), (int)powers.size(), format);
+		for (double value : powers) {
+			ticks.labels.push_back(makeLabel(value, format, Format::commonPrecision(&value, 1, format)));
+		}
+
+		// The closest pair of minor ticks is 9 and 10.
+		long long firstDecade = (long long)std::floor(minLog);
+		long long lastDecade = (long long)std::ceil(maxLog);
+		if (decadeStep == 1 && std::log10(10.0 / 9.0) * pixelsPerDecade >= SP_MIN_MINOR_TICK_SPACING) {
+			for (long long decade = firstDecade; decade < lastDecade; decade++) {
+				for (int m = 2; m <= 9; m++) {
+					double position = decade + std::log10((double)m);
+					if (position >= minLog && position <= maxLog) {
+						ticks.minor.push_back(position);
+					}
+				}
+			}
+		}
+		else if (decadeStep > 1 && pixelsPerDecade >= SP_MIN_MINOR_TICK_SPACING) {
+			for (long long decade = firstDecade; decade <= lastDecade; decade++) {
+				if (decade % decadeStep != 0 && decade >= minLog && decade <= maxLog) {
+					ticks.minor.push_back((double)decade);
+				}
+			}
+		}
+		return ticks;
+	}
+
+	TickSet makeTimeTicks(long long origin, double minT, double maxT, int pixelLength, int minSpacing) {
+		TickSet ticks;
+		// Offsets past what a long long holds can't be ticked anyway.
+		minT = (std::max)(minT, -9.2e18);
+		maxT = (std::min)(maxT, 9.2e18);
+		double range = maxT - minT;
+		if (!std::isfinite(range) || range <= 0 || pixelLength <= 0) {
+			return ticks;
+		}
+
+		TimeStep step = chooseTimeStep(range / pixelLength, (std::max)(minSpacing, 1));
+		ticks.step = (double)step.step;
+		if (step.minor > 0 && step.minor * (pixelLength / range) >= SP_MIN_MINOR_TICK_SPACING) {
+			ticks.minorStep = (double)step.minor;
+		}
+
+		// Work in whole nanoseconds from here on, relative to the origin only when handing out positions. The
+		// bounds keep a step clear of the ends of long long, so rounding up to the first tick can't overflow,
+		// and the loops stop before stepping past the last.
+		long long limit = LLONG_MAX - step.step - step.phase;
+		long long low = addClamped(origin, (long long)std::ceil(minT), limit);
+		long long high = addClamped(origin, (long long)std::floor(maxT), limit);
+		long long first = (floorDiv(low - step.phase - 1, step.step) + 1) * step.step + step.phase;
+		for (long long t = first; t <= high; t += step.step) {
+			ticks.major.push_back((double)(t - origin));
+			ticks.labels.push_back(makeTimeLabel(t, step.step));
+			if (t > high - step.step) { break; }
+		}
+
+		if (ticks.minorStep > 0) {
+			long long firstMinor = (floorDiv(low - step.phase - 1, step.minor) + 1) * step.minor + step.phase;
+			for (long long t = firstMinor; t <= high; t += step.minor) {
+				if ((t - step.phase) % step.step != 0) {
+					ticks.minor.push_back((double)(t - origin));
+				}
+				if (t > high - step.minor) { break; }
+			}
+		}
+		return ticks;
+	}
+
+	TickSet const& TickCache::update(double minT, double maxT, int pixelLength, bool logarithmic, NUMBER_FORMAT format) {
+		if (!valid || cachedTime || minT != cachedMin || maxT != cachedMax || pixelLength != cachedLength
+			|| logarithmic != cachedLogarithmic || format != cachedFormat) {
+			ticks = logarithmic ? makeLogTicks(minT, maxT, pixelLength, format) : makeLinearTicks(minT, maxT, pixelLength, format);
+			cachedMin = minT;
+			cachedMax = maxT;
+			cachedLength = pixelLength;
+			cachedLogarithmic = logarithmic;
+			cachedFormat = format;
+			cachedTime = false;
+			valid = true;
+		}
+		return ticks;
+	}
+
+	TickSet const& TickCache::updateTime(long long origin, double minT, double maxT, int pixelLength) {
+		if (!valid || !cachedTime || origin != cachedOrigin || minT != cachedMin || maxT != cachedMax || pixelLength != cachedLength) {
+			ticks = makeTimeTicks(origin, minT, maxT, pixelLength);
+			cachedOrigin = origin;
+			cachedMin = minT;
+			cachedMax = maxT;
+			cachedLength = pixelLength;
+			cachedTime = true;
+			valid = true;
+		}
+		return ticks;
+	}
+}
\ No newline at end of file
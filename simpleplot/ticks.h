@@ -0,0 +1,56 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "standard.h"
+
+
+namespace SimplePlot::Ticks {
+	struct TickSet {
+		double step = 0;// Spacing of the major ticks
+		double minorStep = 0;// Spacing of the minor ticks, or 0 if there are none
+		int precision = 0;// Digits after the point in the labels of a linear axis
+		std::vector<double> major;
+		std::vector<std::wstring> labels;// One per major tick
+		std::vector<double> minor;// Minor ticks which don't coincide with a major one
+	};
+
+	// Major ticks at a multiple of 1, 2 or 5 times a power of ten, chosen so that neighbouring ticks are at
+	// least minSpacing pixels apart. The work is proportional to the number of ticks that fit on the axis,
+	// whatever the range of the data.
+	TickSet makeLinearTicks(double minT, double maxT, int pixelLength, NUMBER_FORMAT format = NUMBER_FORMAT::AUTO,
+		int minSpacing = SP_MIN_TICK_SPACING);
+
+	// Ticks for a logarithmic axis. minLog and maxLog are the limits' log10, and the returned positions are in
+	// that space too. Ticks fall on whole decades (or every second, fifth, ... decade on a crowded axis), with
+	// minor ticks at 2..9 times each decade when they fit. Ranges with fewer than two whole decades in view fall
+	// back to round numbers in data space.
+	TickSet makeLogTicks(double minLog, double maxLog, int pixelLength, NUMBER_FORMAT format = NUMBER_FORMAT::AUTO,
+		int minSpacing = SP_MIN_TICK_SPACING);
+
+	// Ticks for a time axis of nanoseconds since the Unix epoch (UTC). Positions are relative to origin, so
+	// that a double holds them to the nanosecond, and they fall on calendar boundaries: round numbers of
+	// nanoseconds up to a second, then 1, 2, 5, 10, 15 and 30 seconds and minutes, 1, 2, 3, 6 and 12 hours,
+	// days and weeks (starting on Monday). Labels show as much of the date and time as the step needs.
+	TickSet makeTimeTicks(long long origin, double minT, double maxT, int pixelLength, int minSpacing = SP_MIN_TICK_SPACING);
+
+	// Holds the tick set for the most recent (limits, pixel length, mode), so that it is only rebuilt when one
+	// of them changes.
+	class TickCache {
+	public:
+		TickSet const& update(double minT, double maxT, int pixelLength, bool logarithmic = false, NUMBER_FORMAT format = NUMBER_FORMAT::AUTO);
+		TickSet const& updateTime(long long origin, double minT, double maxT, int pixelLength);
+		TickSet const& current() const { return ticks; }
+
+	private:
+		bool valid = false;
+		double cachedMin = 0;
+		double cachedMax = 0;
+		int cachedLength = 0;
+		bool cachedLogarithmic = false;
+		NUMBER_FORMAT cachedFormat = NUMBER_FORMAT::AUTO;
+		bool cachedTime = false;
+		long long cachedOrigin = 0;
+		TickSet ticks;
+	};
+}
\ No newline at end of file
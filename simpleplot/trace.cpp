@@ -0,0 +1,173 @@
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "trace.h"
+
+
+namespace SimplePlot {
+	namespace Trace {
+		namespace {
+			struct Event {
+				char const* name;
+				char const* category;
+				Clock::time_point begin;
+				Clock::time_point end;
+				long long id;
+			};
+
+			// Only its own thread appends and only the flusher takes events out, so the mutex is almost never
+			// contended. The session keeps a reference after the thread exits until its events are written.
+			struct ThreadBuffer {
+				std::mutex mutex;
+				std::vector<Event> events;
+				int tid = 0;
+			};
+
+			struct Session {
+				std::mutex control;// Serialises startTrace and stopTrace
+				std::mutex mutex;// Guards buffers, nextTid and stopping
+				std::condition_variable wake;
+				std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+				int nextTid = 1;
+				bool stopping = false;
+				std::thread flusher;
+				std::ofstream file;// Only the flusher writes between start and stop
+				Clock::time_point origin;
+				bool firstEvent = true;
+
+				void finish() {
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						stopping = true;
+					}
+					wake.notify_one();
+					flusher.join();
+					file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+					file.close();
+				}
+
+				~Session() {
+					// A trace still running at exit is closed off so the file stays valid JSON.
+					if (flusher.joinable()) {
+						tracing.store(false, std::memory_order_relaxed);
+						finish();
+					}
+				}
+			};
+
+			Session& getSession() {
+				static Session session;
+				return session;
+			}
+
+			thread_local std::shared_ptr<ThreadBuffer> localBuffer;
+
+			void writeEvents(Session& session, int tid, std::vector<Event> const& events) {
+				char line[256];
+				for (Event const& event : events) {
+					if (event.begin < session.origin) { continue; }// Began before this trace did
+					double ts = std::chrono::duration<double, std::micro>(event.begin - session.origin).count();
+					double dur = std::chrono::duration<double, std::micro>(event.end - event.begin).count();
+					int length = std::snprintf(line, sizeof(line),
+						"%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+						session.firstEvent ? "" : ",\n", event.name, event.category, tid, ts, dur);
+					if (event.id != SP_TRACE_NO_ID) {
+						length += std::snprintf(line + length, sizeof(line) - length, ",\"args\":{\"id\":%lld}", event.id);
+					}
+					length += std::snprintf(line + length, sizeof(line) - length, "}");
+					session.file.write(line, length);
+					session.firstEvent = false;
+				}
+			}
+
+			void flusherLoop(Session& session) {
+				std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+				std::vector<Event> events;
+				bool stopping = false;
+				while (!stopping) {
+					{
+						std::unique_lock<std::mutex> lock(session.mutex);
+						session.wake.wait_for(lock, std::chrono::milliseconds(SP_TRACE_FLUSH_MS), [&session] { return session.stopping; });
+						stopping = session.stopping;
+						buffers = session.buffers;
+					}
+					for (std::shared_ptr<ThreadBuffer> const& buffer : buffers) {
+						{
+							std::lock_guard<std::mutex> guard(buffer->mutex);
+							events.swap(buffer->events);
+						}
+						writeEvents(session, buffer->tid, events);
+						events.clear();
+					}
+					buffers.clear();
+					session.file.flush();
+
+					// Forget the buffers of threads that have exited and been written out.
+					std::lock_guard<std::mutex> lock(session.mutex);
+					for (size_t i = 0; i < session.buffers.size();) {
+						std::shared_ptr<ThreadBuffer>& buffer = session.buffers[i];
+						std::lock_guard<std::mutex> guard(buffer->mutex);
+						if (buffer.use_count() == 1 && buffer->events.empty()) {
+							session.buffers.erase(session.buffers.begin() + i);
+						}
+						else {
+							i++;
+						}
+					}
+				}
+			}
+		}
+
+		void emit(char const* name, char const* category, Clock::time_point begin, Clock::time_point end, long long id) {
+			if (!localBuffer) {
+				localBuffer = std::make_shared<ThreadBuffer>();
+				Session& session = getSession();
+				std::lock_guard<std::mutex> guard(session.mutex);
+				localBuffer->tid = session.nextTid++;
+				session.buffers.push_back(localBuffer);
+			}
+			std::lock_guard<std::mutex> guard(localBuffer->mutex);
+			localBuffer->events.push_back({ name, category, begin, end, id });
+		}
+	}
+
+	bool startTrace(std::wstring const& path) {
+		Trace::Session& session = Trace::getSession();
+		std::lock_guard<std::mutex> control(session.control);
+		if (Trace::isTracing()) { return false; }
+
+		session.file = std::ofstream(std::filesystem::path(path), std::ios::binary | std::ios::trunc);
+		if (!session.file) { return false; }
+		session.file << "{\"traceEvents\":[\n";
+		session.firstEvent = true;
+
+		{
+			// Events left over from a previous trace are dropped.
+			std::lock_guard<std::mutex> lock(session.mutex);
+			for (std::shared_ptr<Trace::ThreadBuffer>& buffer : session.buffers) {
+				std::lock_guard<std::mutex> guard(buffer->mutex);
+				buffer->events.clear();
+			}
+			session.stopping = false;
+		}
+		session.origin = Trace::Clock::now();
+		session.flusher = std::thread(Trace::flusherLoop, std::ref(session));
+		Trace::tracing.store(true, std::memory_order_relaxed);
+		return true;
+	}
+
+	void stopTrace() {
+		Trace::Session& session = Trace::getSession();
+		std::lock_guard<std::mutex> control(session.control);
+		if (!Trace::isTracing()) { return; }
+
+		Trace::tracing.store(false, std::memory_order_relaxed);
+		session.finish();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include "standard.h"
+
+
+namespace SimplePlot {
+	// Writes Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev) for everything that happens until
+	// stopTrace: frames, extent passes, plot draws, rasterization, export encoding and waits on the map locks.
+	// Events are buffered per thread and written by a background thread. False if already tracing or the file
+	// could not be opened.
+	bool startTrace(std::wstring const& path);
+	void stopTrace();// Writes whatever is buffered and closes the file
+
+	namespace Trace {
+		inline std::atomic<bool> tracing = false;
+
+		inline bool isTracing() {
+			return tracing.load(std::memory_order_relaxed);
+		}
+
+		typedef std::chrono::steady_clock Clock;
+
+		// name and category must be string literals: only the pointers are kept until the flush.
+		void emit(char const* name, char const* category, Clock::time_point begin, Clock::time_point end, long long id);
+
+		// A complete event from construction to destruction. id is shown as the event's argument, or left out if
+		// it is SP_TRACE_NO_ID. When tracing is off this is one relaxed load.
+		class Span {
+		public:
+			Span(char const* name, char const* category, long long id = SP_TRACE_NO_ID)
+				: name(name), category(category), id(id), active(isTracing()) {
+				if (active) { begin = Clock::now(); }
+			}
+			~Span() {
+				if (active) { emit(name, category, begin, Clock::now(), id); }
+			}
+			Span(Span const&) = delete;
+			Span& operator=(Span const&) = delete;
+
+		private:
+			char const* name;
+			char const* category;
+			long long id;
+			bool active;
+			Clock::time_point begin;
+		};
+	}
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+#include "transform.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SP_TRANSFORM_SSE2
+#include <emmintrin.h>
+#endif
+
+
+namespace SimplePlot::Transform {
+	namespace {
+		const float log10e = 0.434294481903251828f;
+		const float ln2 = 0.693147180559945309f;
+
+#ifdef SP_TRANSFORM_SSE2
+		// Natural log of four normal, positive floats. The exponent is taken from the bits, and the mantissa,
+		// shifted into [sqrt(1/2), sqrt(2)), goes through the Cephes logf polynomial (about 1 ulp).
+		inline __m128 log4(__m128 x) {
+			__m128i bits = _mm_castps_si128(x);
+			__m128i exponent = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+			__m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+
+			__m128 big = _mm_cmpgt_ps(m, _mm_set1_ps(1.41421356f));
+			m = _mm_or_ps(_mm_and_ps(big, _mm_mul_ps(m, _mm_set1_ps(0.5f))), _mm_andnot_ps(big, m));
+			__m128 e = _mm_add_ps(_mm_cvtepi32_ps(exponent), _mm_and_ps(big, _mm_set1_ps(1.0f)));
+
+			__m128 f = _mm_sub_ps(m, _mm_set1_ps(1.0f));
+			__m128 z = _mm_mul_ps(f, f);
+			__m128 y = _mm_set1_ps(7.0376836292e-2f);
+			y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(-1.1514610310e-1f));
+			y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(1.1676998740e-1f));
+			y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(-1.2420140846e-1f));
+			y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(1.4249322787e-1f));
+			y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(-1.6668057665e-1f));
+			y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(2.0000714765e-1f));
+			y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(-2.4999993993e-1f));
+			y = _mm_add_ps(_mm_mul_ps(y, f), _mm_set1_ps(3.3333331174e-1f));
+			y = _mm_mul_ps(_mm_mul_ps(y, f), z);
+			y = _mm_sub_ps(y, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+			return _mm_add_ps(_mm_add_ps(f, y), _mm_mul_ps(e, _mm_set1_ps(ln2)));
+		}
+#endif
+
+		void log10Floats(float const* in, float* out, int size) {
+			int i = 0;
+#ifdef SP_TRANSFORM_SSE2
+			const __m128 minNormal = _mm_set1_ps(FLT_MIN);
+			const __m128 maxFinite = _mm_set1_ps(FLT_MAX);
+			for (; i + 4 <= size; i += 4) {
+				__m128 x = _mm_loadu_ps(in + i);
+				_mm_storeu_ps(out + i, _mm_mul_ps(log4(x), _mm_set1_ps(log10e)));
+				// Zero, negative, denormal, infinite and NaN inputs are rare; redo those lanes exactly.
+				int special = _mm_movemask_ps(_mm_or_ps(_mm_cmpnge_ps(x, minNormal), _mm_cmpngt_ps(maxFinite, x)));
+				if (special) {
+					for (int lane = 0; lane < 4; lane++) {
+						if (special & (1 << lane)) {
+							out[i + lane] = std::log10(in[i + lane]);
+						}
+					}
+				}
+			}
+#endif
+			for (; i < size; i++) {
+				out[i] = std::log10(in[i]);
+			}
+		}
+	}
+
+	template<typename T>
+	void log10(T const* in, float* out, int size) {
+		// Convert a block at a time so the kernel always works on floats.
+		const int blockSize = 1024;
+		float block[blockSize];
+		for (int begin = 0; begin < size; begin += blockSize) {
+			int count = (std::min)(blockSize, size - begin);
+			for (int i = 0; i < count; i++) {
+				block[i] = (float)in[begin + i];
+			}
+			log10Floats(block, out + begin, count);
+		}
+	}
+
+	template<>
+	void log10<float>(float const* in, float* out, int size) {
+		log10Floats(in, out, size);
+	}
+
+	template void log10<double>(double const* in, float* out, int size);
+	template void log10<int>(int const* in, float* out, int size);
+	template void log10<long long>(long long const* in, float* out, int size);
+
+
+	template<typename T>
+	float const* LogCache::get(T const* data, int size, unsigned long long version) {
+		if (data == source && size == cachedSize && version == cachedVersion) {
+			return values.data();
+		}
+
+		values.resize((std::max)(size, 0));
+		log10<T>(data, values.data(), size);
+		bool any = false;
+		minLog = maxLog = 0;
+		for (float v : values) {
+			if (!std::isfinite(v)) { continue; }
+			if (!any) {
+				minLog = maxLog = v;
+				any = true;
+			}
+			minLog = (std::min)(minLog, v);
+			maxLog = (std::max)(maxLog, v);
+		}
+
+		source = data;
+		cachedSize = size;
+		cachedVersion = version;
+		return values.data();
+	}
+
+	template float const* LogCache::get<float>(float const* data, int size, unsigned long long version);
+	template float const* LogCache::get<double>(double const* data, int size, unsigned long long version);
+	template float const* LogCache::get<int>(int const* data, int size, unsigned long long version);
+	template float const* LogCache::get<long long>(long long const* data, int size, unsigned long long version);
+}
\ No newline at end of file
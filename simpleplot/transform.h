@@ -0,0 +1,78 @@
+#pragma once
+#include <cmath>
+#include <type_traits>
+#include <vector>
+
+
+namespace SimplePlot::Transform {
+	// out[i] = log10(in[i]) in single precision. Zero and negative inputs give -inf and NaN, as std::log10 does.
+	template<typename T>
+	void log10(T const* in, float* out, int size);
+
+	// Takes positions along an axis to pixels. Each position is measured from origin in double precision
+	// before it is narrowed, so data far from zero doesn't jitter, and what is left is one multiply-add per
+	// value. The multiply-add is fused where the target has FMA.
+	class AffineMap {
+	public:
+		AffineMap(double minValue, double maxValue, double minPixel, double maxPixel)
+			: origin(minValue), offset((float)minPixel),
+			scale(maxValue != minValue ? float((maxPixel - minPixel) / (maxValue - minValue)) : 0.0f) {}
+
+		float operator()(double value) const {
+			float fromOrigin = (float)(value - origin);
+#if defined(__FMA__) || defined(__AVX2__)
+			return std::fma(fromOrigin, scale, offset);
+#else
+			return fromOrigin * scale + offset;
+#endif
+		}
+
+		double origin;// Axis position that lands on offset
+		float offset;// In pixels
+		float scale;// Pixels per unit along the axis; negative for reversed limits, 0 when the limits meet
+	};
+
+	// A value's position along an axis, relative to the axis origin. Integers are subtracted before the
+	// conversion to double, so int64 nanosecond timestamps keep their resolution.
+	template<typename T>
+	double relative(T value, long long origin) {
+		if constexpr (std::is_integral_v<T>) {
+			return (double)((long long)value - origin);
+		}
+		else {
+			return (double)value - (double)origin;
+		}
+	}
+
+	// The per-point work of Line and Series: a point's positions along both axes to pixels. A position that
+	// isn't finite puts NAN in both coordinates, which breaks the line there.
+	inline void mapPoint(AffineMap const& mapX, AffineMap const& mapY, double fx, double fy, float& x, float& y) {
+		if (!std::isfinite(fx) || !std::isfinite(fy)) {
+			x = y = NAN;
+			return;
+		}
+		x = mapX(fx);
+		y = mapY(fy);
+	}
+
+	// The log10 of a plot's data, kept between frames. It is only recomputed when the data pointer, its size
+	// or the plot's data version changes.
+	class LogCache {
+	public:
+		template<typename T>
+		float const* get(T const* data, int size, unsigned long long version);
+
+		// Extremes of the finite values from the last get; both are 0 if there were none.
+		float minValue() const { return minLog; }
+		float maxValue() const { return maxLog; }
+		long long bytes() const { return (long long)(values.capacity() * sizeof(float)); }
+
+	private:
+		void const* source = nullptr;
+		int cachedSize = -1;
+		unsigned long long cachedVersion = 0;
+		std::vector<float> values;
+		float minLog = 0;
+		float maxLog = 0;
+	};
+}
\ No newline at end of file